@@ -0,0 +1,144 @@
+#ifndef ARGUMENTS_HPP
+#define ARGUMENTS_HPP
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "hortex.hpp"
+
+// Helpers for the console arguments of the scripts
+
+// Parses the value true or false
+inline bool parse_bool(const std::string &arg, bool &value) {
+    if (arg != "true" && arg != "false") {
+        return false;
+    }
+    value = arg == "true";
+    return true;
+}
+
+// Parses a decimal number in [min, max]
+inline bool parse_number(const std::string &arg, const unsigned long long min, const unsigned long long max,
+                         unsigned long long &value) {
+    if (arg.empty() || arg[0] == '-') {
+        return false;
+    }
+
+    char *end;
+    const unsigned long long parsed = std::strtoull(arg.c_str(), &end, 10);
+
+    if (*end || parsed < min || parsed > max) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Parses an interpretation given as use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx],
+// e.g. true,3,false or true,3,false,true. use_pseudocode_arx defaults to true.
+inline bool parse_interpretation(const std::string &arg, int &id) {
+    std::istringstream stream(arg);
+    std::string use_improved_elm, constants_setting, multiplier_is_outside, use_pseudocode_arx = "true";
+
+    if (!std::getline(stream, use_improved_elm, ',') || !std::getline(stream, constants_setting, ',') ||
+        !std::getline(stream, multiplier_is_outside, ',')) {
+        return false;
+    }
+    std::getline(stream, use_pseudocode_arx, ',');
+    if (!stream.eof()) {
+        return false;
+    }
+
+    bool improved, outside, pseudocode;
+    unsigned long long setting;
+
+    if (!parse_bool(use_improved_elm, improved) || !parse_number(constants_setting, 0, 3, setting) ||
+        !parse_bool(multiplier_is_outside, outside) || !parse_bool(use_pseudocode_arx, pseudocode)) {
+        return false;
+    }
+
+    id = interpretation_id(improved, static_cast<int>(setting), outside, pseudocode);
+    return true;
+}
+
+// Settings of an interpretation in the order use_improved_elm, constants_setting, multiplier_is_outside,
+// use_pseudocode_arx, as printed by check_test_vector.cpp
+inline std::string interpretation_name(const int id, const bool with_arx = true) {
+    std::string name = std::string((id & 16) != 0 ? "true" : "false") + ", " + std::to_string(id >> 2 & 3) + ", " +
+                       ((id & 2) != 0 ? "true" : "false");
+    if (with_arx) {
+        name += (id & 1) != 0 ? ", true" : ", false";
+    }
+    return name;
+}
+
+// Options --checkpoint <file>, --checkpoint-interval <seconds> and --resume of the sweeps, see checkpoint.hpp
+struct CheckpointOptions {
+    std::string path;
+    unsigned long long interval_seconds = 600;
+    bool resume = false;
+};
+
+// Removes the checkpoint options from argv, so that the positional arguments keep their numbers. Returns false if an
+// option lacks its value or --resume is given without --checkpoint.
+inline bool take_checkpoint_options(int &argc, char *argv[], CheckpointOptions &options) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--checkpoint" && i + 1 < argc) {
+            options.path = argv[++i];
+        } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 1, 1ull << 32, options.interval_seconds)) {
+                return false;
+            }
+        } else if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--checkpoint" || arg == "--checkpoint-interval") {
+            return false;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = nullptr;
+    argc = kept;
+    return !options.resume || !options.path.empty();
+}
+
+// Options --progress <seconds> and --progress-json <file> of the sweeps and searches, see progress.hpp
+struct ProgressOptions {
+    unsigned long long interval_seconds = 0;
+    std::string json_path;
+
+    bool enabled() const {
+        return interval_seconds > 0 || !json_path.empty();
+    }
+};
+
+// Removes the progress options from argv like take_checkpoint_options. --progress-json alone reports every 10 seconds.
+inline bool take_progress_options(int &argc, char *argv[], ProgressOptions &options) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--progress" && i + 1 < argc) {
+            if (!parse_number(argv[++i], 1, 1ull << 32, options.interval_seconds)) {
+                return false;
+            }
+        } else if (arg == "--progress-json" && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (arg == "--progress" || arg == "--progress-json") {
+            return false;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = nullptr;
+    argc = kept;
+    if (options.interval_seconds == 0 && !options.json_path.empty()) {
+        options.interval_seconds = 10;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "avalanche.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
+
+// Avalanche and strict avalanche criterion of fFunction (256 x 256 bits) or hortex (message bits x 128 digest bits)
+// for one or all interpretations, see avalanche.hpp. Prints the summary statistics of every interpretation and writes
+// the matrices if an output file is given: as CSV of flip probabilities if its name ends in .csv, otherwise as binary
+// flip counts. With all, the compact interpretation name is inserted before the extension of the output file.
+//
+// ./avalanche <ffunction|hortex> <interpretation|all> <samples> <threads> <message_bytes> <output_file> [--progress <seconds>] [--progress-json <file>]
+
+// "out.csv" for id 19 becomes "out.true-0-true-true.csv"
+std::string output_path(const std::string &path, const int id) {
+	std::string name = interpretation_name(id);
+	name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
+	std::replace(name.begin(), name.end(), ',', '-');
+	const std::size_t dot = path.find_last_of('.');
+	const std::size_t slash = path.find_last_of('/');
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return path + "." + name;
+	}
+	return path.substr(0, dot) + "." + name + path.substr(dot);
+}
+
+void print_statistics(const std::string &name, const AvalancheMatrix &matrix) {
+	const AvalancheStatistics stats = avalanche_statistics(matrix);
+	std::cout << std::left << std::setw(25) << name << std::right << std::fixed << std::setprecision(6)
+			  << std::setw(10) << stats.mean_probability
+			  << std::setw(10) << stats.max_bias << " (" << std::setw(3) << stats.max_bias_input << "," << std::setw(3) << stats.max_bias_output << ")"
+			  << std::setw(10) << stats.sac_violations << " / " << std::setprecision(0) << stats.expected_violations
+			  << std::setprecision(2) << std::setw(10) << stats.mean_avalanche
+			  << std::setw(9) << stats.min_avalanche << " (" << std::setw(3) << stats.min_avalanche_input << ")"
+			  << std::setw(9) << stats.max_avalanche << " (" << std::setw(3) << stats.max_avalanche_input << ")" << std::endl;
+	std::cout.unsetf(std::ios::fixed);
+}
+
+int main(int argc, char *argv[]) {
+	ProgressOptions progress_options;
+	if (!take_progress_options(argc, argv, progress_options)) {
+		std::cerr << "Please provide --progress <seconds> (starting from 1) and --progress-json <file>." << std::endl;
+		return 0;
+	}
+
+	bool of_hortex = false;
+	std::vector<int> interpretations;
+	unsigned long long samples = 100000;
+	unsigned long long thread_count = default_thread_count();
+	unsigned long long message_bytes = 8;
+	std::string output;
+
+	if (argc >= 2) {
+		const std::string function = argv[1];
+		if (function != "ffunction" && function != "hortex") {
+			std::cerr << "Please provide either ffunction or hortex, for the first argument." << std::endl;
+			return 0;
+		}
+		of_hortex = function == "hortex";
+	}
+
+	if (argc < 3 || std::string(argv[2]) == "all") {
+		for (int id = 0; id < interpretation_count; id++) {
+			interpretations.push_back(id);
+		}
+	} else {
+		int interpretation;
+		if (!parse_interpretation(argv[2], interpretation)) {
+			std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx] (e.g. true,3,false) or all, for the second argument." << std::endl;
+			return 0;
+		}
+		interpretations.push_back(interpretation);
+	}
+
+	if (argc >= 4 && !parse_number(argv[3], 1, 1ull << 40, samples)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 5 && !parse_number(argv[4], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the fourth argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 6 && !parse_number(argv[5], 1, 1024, message_bytes)) {
+		std::cerr << "Please provide a number from 1 to 1024, for the fifth argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 7) {
+		output = argv[6];
+	}
+
+	std::unique_ptr<ProgressReporter> progress;
+	if (progress_options.enabled()) {
+		try {
+			progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
+
+	const unsigned threads = static_cast<unsigned>(thread_count);
+	if (of_hortex) {
+		std::cout << "hortex on " << samples << " random messages of " << message_bytes << " bytes: " << 8 * message_bytes
+				  << " x 128 flip probabilities" << std::endl;
+	} else {
+		std::cout << "fFunction on " << samples << " random states: 256 x 256 flip probabilities" << std::endl;
+	}
+	std::cout << "Interpretation               mean p  max |p - 1/2| (in,out)  SAC violations / expected  avalanche   min (in)     max (in)" << std::endl;
+
+	for (const int id : interpretations) {
+		AvalancheMatrix matrix;
+		with_interpretation(id, [&]<typename I>(I) {
+			matrix = of_hortex ? hortex_avalanche<I>(static_cast<std::size_t>(message_bytes), samples, 1, threads, progress.get())
+							   : ffunction_avalanche<I>(samples, 1, threads, progress.get());
+		});
+		print_statistics(interpretation_name(id), matrix);
+
+		if (!output.empty()) {
+			const std::string path = interpretations.size() == 1 ? output : output_path(output, id);
+			try {
+				if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+					write_avalanche_csv(matrix, path);
+				} else {
+					write_avalanche_binary(matrix, path);
+				}
+			} catch (const std::exception &e) {
+				std::cerr << e.what() << std::endl;
+				return 0;
+			}
+		}
+	}
+	return 0;
+}
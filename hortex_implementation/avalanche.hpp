@@ -0,0 +1,276 @@
+#ifndef AVALANCHE_HPP
+#define AVALANCHE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "elm_batch.hpp"
+#include "file_io.hpp"
+#include "hortex.hpp"
+#include "hortex_many.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
+
+// Avalanche and strict avalanche criterion (SAC) of fFunction and hortex. For every sample a random input is
+// evaluated once as it is and once with each single input bit flipped; flips[i][j] counts the samples in which
+// flipping input bit i flipped output bit j. Under the SAC every flip probability flips[i][j] / samples is 1/2.
+//
+// Bits are numbered from the most significant bit of the bit string, as in the std::bitset interfaces: bit i of a
+// state is bit 31 - i % 32 of word i / 32, bit i of a message or digest is bit 7 - i % 8 of byte i / 8.
+//
+// The samples are split into one range per thread and every thread counts into its own matrix; the matrices are
+// added at the end. Sample s is derived from seed and s only (splitmix64), so the matrix does not depend on the
+// thread count. The original and the flipped inputs of a sample are evaluated together with fFunction_many and
+// hortex_many, and one sample of fFunction costs 257 fFunction calls.
+
+// Increment of splitmix64 between the samples
+constexpr uint64_t AVALANCHE_SEED_STEP = 0x9e3779b97f4a7c15;
+
+struct AvalancheMatrix {
+    int input_bits = 0;
+    int output_bits = 0;
+    uint64_t samples = 0;
+    // flips[i * output_bits + j]
+    std::vector<uint64_t> flips;
+
+    AvalancheMatrix() = default;
+
+    AvalancheMatrix(const int inputs, const int outputs)
+        : input_bits(inputs), output_bits(outputs), flips(static_cast<std::size_t>(inputs) * outputs, 0) {
+    }
+
+    void add(const AvalancheMatrix &other) {
+        samples += other.samples;
+        for (std::size_t c = 0; c < flips.size(); c++) {
+            flips[c] += other.flips[c];
+        }
+    }
+
+    double probability(const int input, const int output) const {
+        return samples == 0 ? 0.0 : static_cast<double>(flips[static_cast<std::size_t>(input) * output_bits + output]) / samples;
+    }
+
+    // Counts the bits of difference, an output of output_bits bits in 32-bit words with bit 0 the most significant
+    // bit of words[0], for input bit input
+    void count(const int input, const uint32_t *difference) {
+        uint64_t *row = flips.data() + static_cast<std::size_t>(input) * output_bits;
+        for (int j = 0; j < output_bits; j++) {
+            row[j] += difference[j / 32] >> (31 - j % 32) & 1;
+        }
+    }
+};
+
+struct AvalancheStatistics {
+    // Mean flip probability over all entries, 1/2 under the SAC
+    double mean_probability = 0;
+    // Largest |p - 1/2| and its entry
+    double max_bias = 0;
+    int max_bias_input = 0;
+    int max_bias_output = 0;
+    // Entries outside the two-sided 99.9 % band 1/2 +- 3.29 * sqrt(1 / (4 * samples)) of a fair coin, and the number
+    // expected by chance
+    uint64_t sac_violations = 0;
+    double expected_violations = 0;
+    // Mean number of flipped output bits per flipped input bit, output_bits / 2 for a good diffusion, and the input
+    // bits with the weakest and the strongest avalanche
+    double mean_avalanche = 0;
+    double min_avalanche = 0;
+    int min_avalanche_input = 0;
+    double max_avalanche = 0;
+    int max_avalanche_input = 0;
+};
+
+inline AvalancheStatistics avalanche_statistics(const AvalancheMatrix &matrix) {
+    constexpr double z = 3.290527;
+    AvalancheStatistics stats;
+    const double band = z * std::sqrt(0.25 / static_cast<double>(std::max<uint64_t>(matrix.samples, 1)));
+    const std::size_t entries = matrix.flips.size();
+    stats.expected_violations = 0.001 * static_cast<double>(entries);
+    stats.min_avalanche = matrix.output_bits;
+
+    for (int i = 0; i < matrix.input_bits; i++) {
+        double avalanche = 0;
+        for (int j = 0; j < matrix.output_bits; j++) {
+            const double p = matrix.probability(i, j);
+            avalanche += p;
+            stats.mean_probability += p;
+            if (std::abs(p - 0.5) > stats.max_bias) {
+                stats.max_bias = std::abs(p - 0.5);
+                stats.max_bias_input = i;
+                stats.max_bias_output = j;
+            }
+            if (std::abs(p - 0.5) > band) {
+                stats.sac_violations++;
+            }
+        }
+        stats.mean_avalanche += avalanche;
+        if (avalanche < stats.min_avalanche) {
+            stats.min_avalanche = avalanche;
+            stats.min_avalanche_input = i;
+        }
+        if (avalanche >= stats.max_avalanche) {
+            stats.max_avalanche = avalanche;
+            stats.max_avalanche_input = i;
+        }
+    }
+    stats.mean_probability /= static_cast<double>(std::max<std::size_t>(entries, 1));
+    stats.mean_avalanche /= std::max(matrix.input_bits, 1);
+    return stats;
+}
+
+// Matrix of fFunction<I> over samples random states: 256 input bits, 256 output bits
+template<typename I>
+AvalancheMatrix ffunction_avalanche(const uint64_t samples, const uint64_t seed, const unsigned thread_count,
+                                    ProgressReporter *progress = nullptr) {
+    constexpr int lanes = HORTEX_MANY_LANES;
+    ProgressRun run(progress, {"fFunction avalanche", thread_count, samples});
+    std::vector<AvalancheMatrix> matrices(thread_count, AvalancheMatrix(256, 256));
+
+    parallel_ranges(thread_count, samples, [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        AvalancheMatrix &matrix = matrices[t];
+        // states[0] is the sample, states[1 + i] the sample with bit i flipped
+        State states[257];
+        for (uint64_t s = begin; s < end; s++) {
+            uint64_t random = mix64(seed + s * AVALANCHE_SEED_STEP);
+            for (int w = 0; w < 8; w += 2) {
+                states[0][w] = static_cast<uint32_t>(random >> 32);
+                states[0][w + 1] = static_cast<uint32_t>(random);
+                random = mix64(random);
+            }
+            for (int i = 0; i < 256; i++) {
+                states[1 + i] = states[0];
+                states[1 + i][i / 32] ^= uint32_t{1} << (31 - i % 32);
+            }
+
+            for (int first = 0; first < 257; first += lanes) {
+                fFunction_many<I, lanes>(states + first, std::min(lanes, 257 - first));
+            }
+
+            for (int i = 0; i < 256; i++) {
+                uint32_t difference[8];
+                for (int w = 0; w < 8; w++) {
+                    difference[w] = states[1 + i][w] ^ states[0][w];
+                }
+                matrix.count(i, difference);
+            }
+            matrix.samples++;
+            run.add(t, 1, 257 * 8, 0);
+        }
+    });
+
+    AvalancheMatrix result(256, 256);
+    for (const AvalancheMatrix &matrix : matrices) {
+        result.add(matrix);
+    }
+    return result;
+}
+
+// Matrix of hortex<I> over samples random messages of message_bytes bytes: 8 * message_bytes input bits, 128 output
+// bits
+template<typename I>
+AvalancheMatrix hortex_avalanche(const std::size_t message_bytes, const uint64_t samples, const uint64_t seed,
+                                 const unsigned thread_count, ProgressReporter *progress = nullptr) {
+    constexpr int digest_bits = 8 * Hortex<I>::digest_size;
+    const int input_bits = static_cast<int>(8 * message_bytes);
+    const std::size_t calls = (message_bytes + 7) / 8 + 2;
+    ProgressRun run(progress, {"hortex avalanche", thread_count, samples});
+    std::vector<AvalancheMatrix> matrices(thread_count, AvalancheMatrix(input_bits, digest_bits));
+
+    parallel_ranges(thread_count, samples, [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        AvalancheMatrix &matrix = matrices[t];
+        const std::size_t count = static_cast<std::size_t>(input_bits) + 1;
+        // Message 0 is the sample, message 1 + i the sample with bit i flipped
+        std::vector<uint8_t> bytes(count * message_bytes);
+        std::vector<HortexMessage> messages(count);
+        std::vector<uint8_t> digests(count * Hortex<I>::digest_size);
+        for (std::size_t m = 0; m < count; m++) {
+            messages[m] = {bytes.data() + m * message_bytes, message_bytes};
+        }
+
+        for (uint64_t s = begin; s < end; s++) {
+            uint64_t random = mix64(seed + s * AVALANCHE_SEED_STEP);
+            for (std::size_t b = 0; b < message_bytes; b++) {
+                if (b % 8 == 0 && b > 0) {
+                    random = mix64(random);
+                }
+                bytes[b] = static_cast<uint8_t>(random >> (56 - 8 * (b % 8)));
+            }
+            for (int i = 0; i < input_bits; i++) {
+                uint8_t *message = bytes.data() + (1 + static_cast<std::size_t>(i)) * message_bytes;
+                std::memcpy(message, bytes.data(), message_bytes);
+                message[i / 8] ^= static_cast<uint8_t>(0x80 >> (i % 8));
+            }
+
+            hortex_many<I>(messages.data(), count, digests.data());
+
+            for (int i = 0; i < input_bits; i++) {
+                const uint8_t *digest = digests.data() + (1 + static_cast<std::size_t>(i)) * Hortex<I>::digest_size;
+                uint32_t difference[digest_bits / 32];
+                for (int w = 0; w < digest_bits / 32; w++) {
+                    difference[w] = 0;
+                    for (int b = 0; b < 4; b++) {
+                        difference[w] = difference[w] << 8 | static_cast<uint32_t>(digest[4 * w + b] ^ digests[4 * w + b]);
+                    }
+                }
+                matrix.count(i, difference);
+            }
+            matrix.samples++;
+            run.add(t, 1, count * calls * 8, 0);
+        }
+    });
+
+    AvalancheMatrix result(input_bits, digest_bits);
+    for (const AvalancheMatrix &matrix : matrices) {
+        result.add(matrix);
+    }
+    return result;
+}
+
+// One line per input bit with the flip probabilities of all output bits
+inline void write_avalanche_csv(const AvalancheMatrix &matrix, const std::string &path) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    out << std::fixed << std::setprecision(6);
+    for (int i = 0; i < matrix.input_bits; i++) {
+        for (int j = 0; j < matrix.output_bits; j++) {
+            out << (j > 0 ? "," : "") << matrix.probability(i, j);
+        }
+        out << "\n";
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+constexpr char AVALANCHE_MAGIC[8] = {'H', 'R', 'T', 'X', 'A', 'V', 'A', 'L'};
+
+// The magic, input_bits and output_bits as uint32, samples as uint64 and the flip counts as uint64 in row order,
+// all little-endian. The counts are exact, so the matrices of several runs with different seeds can be added.
+inline void write_avalanche_binary(const AvalancheMatrix &matrix, const std::string &path) {
+    static_assert(std::endian::native == std::endian::little, "the avalanche file is written in native byte order");
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    const uint32_t dimensions[2] = {static_cast<uint32_t>(matrix.input_bits), static_cast<uint32_t>(matrix.output_bits)};
+    out.write(AVALANCHE_MAGIC, sizeof(AVALANCHE_MAGIC));
+    out.write(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+    out.write(reinterpret_cast<const char *>(&matrix.samples), sizeof(matrix.samples));
+    out.write(reinterpret_cast<const char *>(matrix.flips.data()), static_cast<std::streamsize>(matrix.flips.size() * sizeof(uint64_t)));
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+#endif
@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "arguments.hpp"
+#include "elm_batch.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "hortex_many.hpp"
+#include "sweep.hpp"
+
+// Benchmarks of ELM, fFunction and hortex for every interpretation and backend. Every benchmark runs twice for
+// warm-up and then the given number of times, and reports the median, the quartiles and the extremes of the time per
+// unit (one ELM, one fFunction call or one message byte) in nanoseconds and in cycles of the time stamp counter.
+//
+//   elm_latency      ELM calls that depend on each other, inputs with the same iteration count n
+//   elm_throughput   independent ELM calls of the backend, inputs with the same iteration count n
+//   ffunction        fFunction calls that depend on each other
+//   hortex           hortex of messages from 8 bytes to max_message_bytes, time per byte
+//   hortex_many      hortex_many of HORTEX_MANY_MESSAGES messages of 8 and 64 bytes, time per message
+//
+// Backends: scalar is ELM<I>, avx2 and avx512 are ELM_batch, table reads the ELM table given as last argument (only
+// for its interpretation).
+//
+// ./benchmark <suite> <interpretation> <repetitions> <max_message_bytes> <json_file> <table_file>
+
+constexpr int WARM_UP_RUNS = 2;
+
+// Inputs per ELM benchmark run and fFunction calls per fFunction benchmark run
+constexpr std::size_t ELM_BENCHMARK_INPUTS = 4096;
+constexpr std::size_t FFUNCTION_BENCHMARK_CALLS = 256;
+constexpr std::size_t HORTEX_MANY_MESSAGES = 1024;
+constexpr std::size_t XOF_BENCHMARK_BYTES = 16384;
+
+// Keeps the compiler from removing the benchmarked calls
+volatile uint64_t benchmark_sink;
+
+inline uint64_t cycle_count() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+struct Quantiles {
+	double min;
+	double q1;
+	double median;
+	double q3;
+	double max;
+};
+
+inline Quantiles quantiles(std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	auto at = [&](const double q) {
+		const double position = q * static_cast<double>(samples.size() - 1);
+		const std::size_t i = static_cast<std::size_t>(position);
+		const double weight = position - static_cast<double>(i);
+		return i + 1 < samples.size() ? samples[i] * (1 - weight) + samples[i + 1] * weight : samples[i];
+	};
+	return {samples.front(), at(0.25), at(0.5), at(0.75), samples.back()};
+}
+
+struct BenchmarkResult {
+	std::string benchmark;
+	std::string interpretation;
+	std::string backend;
+	// Iteration count n for the ELM benchmarks, message length in bytes for hortex
+	std::string parameter_name;
+	uint64_t parameter;
+	std::string unit;
+	Quantiles nanoseconds{};
+	Quantiles cycles{};
+};
+
+class Benchmark {
+public:
+	Benchmark(const int repetitions, const std::string &json_path) : repetitions(repetitions), json_path(json_path) {
+	}
+
+	// Runs run() WARM_UP_RUNS + repetitions times, run processes units units per call
+	template<typename F>
+	void measure(BenchmarkResult result, const double units, F &&run) {
+		std::vector<double> nanoseconds, cycles;
+
+		for (int i = 0; i < WARM_UP_RUNS + repetitions; i++) {
+			const auto start = std::chrono::steady_clock::now();
+			const uint64_t start_cycles = cycle_count();
+			run();
+			const uint64_t end_cycles = cycle_count();
+			const auto end = std::chrono::steady_clock::now();
+
+			if (i >= WARM_UP_RUNS) {
+				nanoseconds.push_back(std::chrono::duration<double, std::nano>(end - start).count() / units);
+				cycles.push_back(static_cast<double>(end_cycles - start_cycles) / units);
+			}
+		}
+
+		result.nanoseconds = quantiles(nanoseconds);
+		result.cycles = quantiles(cycles);
+
+		std::cout << std::left << std::setw(16) << result.benchmark << std::setw(24) << result.interpretation
+				  << std::setw(8) << result.backend << std::setw(6) << result.parameter_name << std::setw(12)
+				  << result.parameter << std::right << std::fixed << std::setprecision(2) << std::setw(10)
+				  << result.nanoseconds.median << " ns " << std::setw(10) << result.cycles.median << " cycles per "
+				  << result.unit << "  (IQR " << result.nanoseconds.q1 << " - " << result.nanoseconds.q3 << " ns)"
+				  << std::defaultfloat << std::endl;
+
+		results.push_back(result);
+	}
+
+	// Writes all results as JSON, returns false if the file could not be written
+	bool write_json() const {
+		if (json_path.empty()) {
+			return true;
+		}
+
+		std::ofstream file(json_path);
+		file << std::setprecision(6);
+		file << "{\n  \"backend\": \"" << backend_name(detected_backend()) << "\",\n  \"warm_up_runs\": " << WARM_UP_RUNS
+			 << ",\n  \"repetitions\": " << repetitions << ",\n  \"results\": [";
+
+		auto write_quantiles = [&](const char *name, const Quantiles &q) {
+			file << "\"" << name << "\": {\"min\": " << q.min << ", \"q1\": " << q.q1 << ", \"median\": " << q.median
+				 << ", \"q3\": " << q.q3 << ", \"max\": " << q.max << "}";
+		};
+
+		for (std::size_t i = 0; i < results.size(); i++) {
+			const BenchmarkResult &r = results[i];
+			file << (i == 0 ? "\n" : ",\n") << "    {\"benchmark\": \"" << r.benchmark << "\", \"interpretation\": \""
+				 << r.interpretation << "\", \"backend\": \"" << r.backend << "\", \"" << r.parameter_name << "\": "
+				 << r.parameter << ", \"unit\": \"" << r.unit << "\", ";
+			write_quantiles("nanoseconds", r.nanoseconds);
+			file << ", ";
+			write_quantiles("cycles", r.cycles);
+			file << "}";
+		}
+		file << "\n  ]\n}\n";
+
+		return static_cast<bool>(file);
+	}
+
+private:
+	int repetitions;
+	std::string json_path;
+	std::vector<BenchmarkResult> results;
+};
+
+// ELM_BENCHMARK_INPUTS random inputs whose iteration count is n, empty if there are none
+template<typename I>
+std::vector<uint32_t> inputs_with_iterations(const int n, std::mt19937 &rng) {
+	// n only depends on x_left
+	std::vector<uint32_t> x_lefts;
+	for (uint32_t x_left = 0; x_left < 4096; x_left++) {
+		if (ELM_parameters<I>(x_left << 20).n == n) {
+			x_lefts.push_back(x_left);
+		}
+	}
+
+	std::vector<uint32_t> inputs;
+	if (x_lefts.empty()) {
+		return inputs;
+	}
+
+	std::uniform_int_distribution<std::size_t> pick(0, x_lefts.size() - 1);
+	std::uniform_int_distribution<uint32_t> low_bits(0, (1u << 20) - 1);
+	for (std::size_t i = 0; i < ELM_BENCHMARK_INPUTS; i++) {
+		inputs.push_back(x_lefts[pick(rng)] << 20 | low_bits(rng));
+	}
+	return inputs;
+}
+
+template<typename I>
+void benchmark_elm(Benchmark &benchmark, const ELMTable *table, std::mt19937 &rng) {
+	const std::string name = interpretation_name(I::id, false);
+	std::vector<uint32_t> outputs(ELM_BENCHMARK_INPUTS);
+
+	for (int n = 0; n <= 6; n++) {
+		const std::vector<uint32_t> inputs = inputs_with_iterations<I>(n, rng);
+		if (inputs.empty()) {
+			continue;
+		}
+		const BenchmarkResult result{"elm_latency", name, "scalar", "n", static_cast<uint64_t>(n), "ELM"};
+		const double units = static_cast<double>(inputs.size());
+
+		// The output only changes x_middle and x_right of the next input, so n stays the same
+		benchmark.measure(result, units, [&] {
+			uint32_t y = 0;
+			for (const uint32_t x : inputs) {
+				y = ELM<I>(x ^ (y & 0xFFFFF));
+			}
+			benchmark_sink = y;
+		});
+
+		BenchmarkResult throughput = result;
+		throughput.benchmark = "elm_throughput";
+		for (const ELMBackend backend : {ELMBackend::Scalar, ELMBackend::AVX2, ELMBackend::AVX512}) {
+			if (!backend_supported(backend)) {
+				continue;
+			}
+			throughput.backend = backend_name(backend);
+			benchmark.measure(throughput, units, [&] {
+				ELM_batch<I>(inputs.data(), outputs.data(), inputs.size(), backend);
+				benchmark_sink = outputs[0];
+			});
+		}
+
+		if (table != nullptr) {
+			const TableELM<I> elm = table->evaluator<I>();
+			throughput.backend = "table";
+			benchmark.measure(throughput, units, [&] {
+				for (std::size_t i = 0; i < inputs.size(); i++) {
+					outputs[i] = elm(inputs[i]);
+				}
+				benchmark_sink = outputs[0];
+			});
+		}
+	}
+}
+
+template<typename I, typename E>
+void benchmark_ffunction(Benchmark &benchmark, const std::string &backend, const E &elm) {
+	const BenchmarkResult result{"ffunction", interpretation_name(I::id), backend, "calls", FFUNCTION_BENCHMARK_CALLS, "fFunction"};
+	benchmark.measure(result, FFUNCTION_BENCHMARK_CALLS, [&] {
+		State state{1, 2, 3, 4, 5, 6, 7, 8};
+		for (std::size_t i = 0; i < FFUNCTION_BENCHMARK_CALLS; i++) {
+			state = fFunction<I>(state, elm);
+		}
+		benchmark_sink = state[0];
+	});
+}
+
+template<typename I, typename E>
+void benchmark_hortex(Benchmark &benchmark, const std::string &backend, const E &elm, const std::vector<uint8_t> &message) {
+	uint8_t digest[Hortex<I, E>::digest_size];
+
+	for (std::size_t len = 8; len <= message.size(); len *= 8) {
+		const BenchmarkResult result{"hortex", interpretation_name(I::id), backend, "len", len, "byte"};
+		benchmark.measure(result, static_cast<double>(len), [&] {
+			hortex<I>(message.data(), len, digest, elm);
+			benchmark_sink = digest[0];
+		});
+	}
+}
+
+// Short messages one after the other with hortex and interleaved with hortex_many
+template<typename I>
+void benchmark_hortex_many(Benchmark &benchmark, const std::vector<uint8_t> &bytes) {
+	std::vector<uint8_t> digests(Hortex<I>::digest_size * HORTEX_MANY_MESSAGES);
+
+	for (const std::size_t len : {std::size_t{8}, std::size_t{64}}) {
+		// The messages are taken from bytes, like the lengths of benchmark_hortex up to max_message_bytes
+		if (len > bytes.size()) {
+			continue;
+		}
+		std::vector<HortexMessage> messages;
+		for (std::size_t i = 0; i < HORTEX_MANY_MESSAGES; i++) {
+			messages.push_back({bytes.data() + (i * 8) % (bytes.size() - len + 1), len});
+		}
+
+		const BenchmarkResult single{"hortex_single", interpretation_name(I::id), "scalar", "len", len, "message"};
+		benchmark.measure(single, HORTEX_MANY_MESSAGES, [&] {
+			for (std::size_t i = 0; i < HORTEX_MANY_MESSAGES; i++) {
+				hortex<I>(messages[i].data, messages[i].len, digests.data() + Hortex<I>::digest_size * i);
+			}
+			benchmark_sink = digests[0];
+		});
+
+		for (const ELMBackend backend : {ELMBackend::Scalar, ELMBackend::AVX2, ELMBackend::AVX512}) {
+			if (!backend_supported(backend)) {
+				continue;
+			}
+			const BenchmarkResult many{"hortex_many", interpretation_name(I::id), backend_name(backend), "len", len, "message"};
+			benchmark.measure(many, HORTEX_MANY_MESSAGES, [&] {
+				hortex_many<I>(messages.data(), messages.size(), digests.data(), backend);
+				benchmark_sink = digests[0];
+			});
+		}
+	}
+}
+
+// A stream of XOF_BENCHMARK_BYTES pseudo-random bytes from one absorb, squeezed in pieces of 64 bytes, against the
+// same stream built from the digests of hortex over a 64-bit counter
+template<typename I>
+void benchmark_hortex_xof(Benchmark &benchmark) {
+	std::vector<uint8_t> stream(XOF_BENCHMARK_BYTES);
+	const uint8_t seed[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+	const BenchmarkResult xof{"hortex_xof", interpretation_name(I::id), "scalar", "len", XOF_BENCHMARK_BYTES, "byte"};
+	benchmark.measure(xof, XOF_BENCHMARK_BYTES, [&] {
+		Hortex<I> ctx;
+		ctx.update(seed, sizeof(seed));
+		ctx.finish();
+		for (std::size_t offset = 0; offset < stream.size(); offset += 64) {
+			ctx.squeeze(stream.data() + offset, 64);
+		}
+		benchmark_sink = stream[0];
+	});
+
+	const BenchmarkResult counter{"hortex_counter", interpretation_name(I::id), "scalar", "len", XOF_BENCHMARK_BYTES, "byte"};
+	benchmark.measure(counter, XOF_BENCHMARK_BYTES, [&] {
+		for (std::size_t offset = 0; offset < stream.size(); offset += Hortex<I>::digest_size) {
+			uint8_t block[8];
+			for (int i = 0; i < 8; i++) {
+				block[i] = static_cast<uint8_t>(offset >> (56 - 8 * i));
+			}
+			hortex<I>(block, sizeof(block), stream.data() + offset);
+		}
+		benchmark_sink = stream[0];
+	});
+}
+
+int main(int argc, char *argv[]) {
+	std::string suite = "all";
+	std::vector<int> interpretations;
+	unsigned long long repetitions = 11;
+	unsigned long long max_message_bytes = 65536;
+	std::string json_path;
+
+	if (argc >= 2) {
+		suite = argv[1];
+		if (suite != "all" && suite != "elm" && suite != "ffunction" && suite != "hortex") {
+			std::cerr << "Please provide all, elm, ffunction or hortex, for the first argument." << std::endl;
+			return 0;
+		}
+	}
+
+	int interpretation;
+	if (argc < 3 || std::string(argv[2]) == "all") {
+		for (int id = 0; id < interpretation_count; id++) {
+			interpretations.push_back(id);
+		}
+	} else if (parse_interpretation(argv[2], interpretation)) {
+		interpretations.push_back(interpretation);
+	} else {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx] (e.g. true,3,false) or all, for the second argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 4 && !parse_number(argv[3], 1, 1000000, repetitions)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 5 && !parse_number(argv[4], 8, 1ull << 30, max_message_bytes)) {
+		std::cerr << "Please provide a number from 8 to 1073741824, for the fourth argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 6 && std::string(argv[5]) != "-") {
+		json_path = argv[5];
+	}
+
+	std::unique_ptr<ELMTable> table;
+	if (argc >= 7) {
+		try {
+			table = std::make_unique<ELMTable>(argv[6]);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Please provide an ELM table written by generate_elm_table, for the sixth argument." << std::endl;
+			return 0;
+		}
+	}
+
+	std::cout << "Backend: " << backend_name(detected_backend()) << ", " << WARM_UP_RUNS << " warm-up runs, "
+			  << repetitions << " repetitions" << std::endl;
+
+	Benchmark benchmark(static_cast<int>(repetitions), json_path);
+	std::mt19937 rng(42);
+
+	std::vector<uint8_t> message(suite == "all" || suite == "hortex" ? max_message_bytes : 0);
+	for (uint8_t &byte : message) {
+		byte = static_cast<uint8_t>(rng());
+	}
+
+	for (const int id : interpretations) {
+		with_interpretation(id, [&]<typename I>(I) {
+			const bool table_matches = table != nullptr && (table->interpretation() | 1) == (I::id | 1);
+
+			// ELM does not depend on use_pseudocode_arx, so its variants are measured once
+			if ((suite == "all" || suite == "elm") && (interpretations.size() == 1 || I::use_pseudocode_arx)) {
+				benchmark_elm<I>(benchmark, table_matches ? table.get() : nullptr, rng);
+			}
+
+			if (suite == "all" || suite == "ffunction") {
+				benchmark_ffunction<I>(benchmark, "scalar", ComputedELM<I>{});
+				if (table_matches) {
+					benchmark_ffunction<I>(benchmark, "table", table->evaluator<I>());
+				}
+			}
+
+			if (suite == "all" || suite == "hortex") {
+				benchmark_hortex<I>(benchmark, "scalar", ComputedELM<I>{}, message);
+				if (table_matches) {
+					benchmark_hortex<I>(benchmark, "table", table->evaluator<I>(), message);
+				}
+				benchmark_hortex_many<I>(benchmark, message);
+				benchmark_hortex_xof<I>(benchmark);
+			}
+		});
+	}
+
+	if (!benchmark.write_json()) {
+		std::cerr << "Could not write " << json_path << "." << std::endl;
+	}
+	return 0;
+}
@@ -1,92 +1,68 @@
-#include <cmath>
-#include <vector>
 #include <chrono>
 #include <iostream>
+#include <memory>
+#include <sstream>
 
-using namespace std::chrono;
-
-// Logistic Map Function
-double fLM(const double eta, const double gamma) {
-    return eta * gamma * (1.0 - gamma);
-}
+#include "arguments.hpp"
+#include "checkpoint.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "slice.hpp"
+#include "sweep.hpp"
 
-// Enhanced Logistic Map Function
-double fELM(const double eta, const double gamma, const double k) {
-    const double fLM_result = fLM(eta, gamma);
-    const double full_result = exp2(k - fLM_result);
+using namespace std::chrono;
 
-    double int_part;
-    const double fractional_part = modf(full_result, &int_part);
+// Method for testing the bijectivity. The outputs are marked in a bitstring of the length 2^{32} (512 MiB) that is shared by all threads.
+// With a slice only its inputs are tested, with a collision structure sized to the slice (slice.hpp).
+template<typename I>
+void bijectivity_test(bool counting_activated, bool timing_activated, unsigned thread_count, const uint32_t *table,
+					  const BijectivityCheckpoint *checkpoint = nullptr, ProgressReporter *progress = nullptr,
+					  const InputSlice *slice = nullptr) {
+	BijectivityResult result;
+	if (slice != nullptr) {
+		const SliceResult slice_result = slice_bijectivity<I>(*slice, counting_activated, thread_count, table);
+		result = slice_result.result;
+		if (!timing_activated) {
+			std::cout << "Slice of " << slice_result.inputs << " inputs, collisions found with a " << slice_method_name(slice_result.method)
+					  << " of " << slice_result.memory << " bytes." << std::endl;
+		}
+	} else {
+		result = bijectivity_sweep<I>(counting_activated, thread_count, table, checkpoint, progress);
+	}
 
-    return fractional_part;
-}
+	if (!counting_activated && result.collision_found && !timing_activated) {
+		std::cout << "Input " << result.collision_input << " collides with another input that produces the output " << result.collision_output << "." << std::endl;
+	}
 
-// Conversion of a real number to the binary representation of the IEEE single precision format
-uint32_t binary32(const double d) {
-    const auto f = static_cast<float>(d);
-    return std::bit_cast<uint32_t>(f);
+	if (counting_activated && !timing_activated) {
+		std::cout << result.collisions << " collision pairs found." << std::endl;
+	}
 }
 
-// ELM Algorithm
-uint32_t ELM(const uint32_t x) {
-    const uint16_t x_left = x >> 20;
-    const uint16_t x_middle = x >> 4 & 0xFFFF;
-    const uint16_t x_right = x & 0xF;
-
-    double gamma = x_left * (1.0 / 4095);
-    const double eta = x_middle * (2.0 / 65535) + 2.0;
-    const double k = x_right * (1.0 / 15) + 10.01;
-
-    const int n = floor(6.0 * gamma);
-
-    uint32_t w1 = 0, w2 = 0;
-
-    for (int i = 0; i <= n + 1; i++) {
-        gamma = fELM(eta, gamma, k);
-
-        if (i == n) {
-            constexpr double FACTOR = 1e10;
-            w1 = binary32(gamma * FACTOR);
-        } else if (i == n + 1) {
-            w2 = binary32(gamma);
-        }
-    }
+// ./bijectivity_test <counting> <timing> <timing_iterations> <threads> <table_file>
+//     [--checkpoint <file>] [--checkpoint-interval <seconds>] [--resume] [--progress <seconds>] [--progress-json <file>]
+//     [--x-left <filter>] [--x-middle <filter>] [--x-right <filter>]
+int main(int argc, char *argv[]) {
+	CheckpointOptions checkpoint_options;
+	if (!take_checkpoint_options(argc, argv, checkpoint_options)) {
+		std::cerr << "Please provide --checkpoint <file>, --checkpoint-interval <seconds> (starting from 1) and --resume only together with --checkpoint." << std::endl;
+		return 0;
+	}
 
-    return std::rotl(w1, 17) ^ w2;
-}
+	ProgressOptions progress_options;
+	if (!take_progress_options(argc, argv, progress_options)) {
+		std::cerr << "Please provide --progress <seconds> (starting from 1) and --progress-json <file>." << std::endl;
+		return 0;
+	}
 
-// Method for testing the bijectivity. 2^{32} bits / 8 bits = 536870912 Bytes thus the vector with 536870912 Bytes represents a bitstring of the length 2^{32}.
-void bijectivity_test(bool counting_activated, bool timing_activated) {
-	std::vector<uint8_t> seen(536870912);
-	int counter = 0;
-	
-    for (uint64_t i = 0; i < 4294967296; i++) {
-        const uint32_t y = ELM(i);
-
-        const int byte_index = floor(y / 8.0);
-        const uint32_t bit_index = y % 8;
-        
-        constexpr uint8_t MAX_BYTE_INDEX = 7;
-        constexpr uint8_t MASK = 0x1;
-		
-        if (seen[byte_index] >> (MAX_BYTE_INDEX - bit_index) & MASK) {
-            if (!counting_activated) {
-				std::cout << "Input " << i << " collides with another input that produces the output " << y << "." << std::endl;
-				break;
-			} else {
-				counter++;
-			}	
-        }
-
-        seen[byte_index] = seen[byte_index] | MASK << (MAX_BYTE_INDEX - bit_index);
-    }
-	
-	if (counting_activated && !timing_activated) {
-		std::cout << counter << " collision pairs found." << std::endl;
-	}	
-}
+	InputSlice input_slice;
+	if (!take_slice_options(argc, argv, input_slice)) {
+		std::cerr << "Please provide --x-left, --x-middle and --x-right as v, lo-hi, value/mask or lo-hi,value/mask, matching at least one input." << std::endl;
+		return 0;
+	}
+	const InputSlice *slice = input_slice.full() ? nullptr : &input_slice;
 
-int main(int argc, char *argv[]) {
 	std::string counting_activated_string = "";
 	bool counting_activated = 0;
 
@@ -101,7 +77,7 @@ int main(int argc, char *argv[]) {
 	std::string timing_activated_string = "";
 	bool timing_activated = 0;
 	
-	if (argc == 3 && std::string(argv[2]) != "true" && std::string(argv[2]) != "false") {
+	if (argc >= 3 && std::string(argv[2]) != "true" && std::string(argv[2]) != "false") {
 		std::cerr << "Please provide either the value true or false, for the second argument." << std::endl;
 		return 0;
 	} else if (argv[2]) {
@@ -111,22 +87,82 @@ int main(int argc, char *argv[]) {
 	
 	int timing_iterations = 10;
 	
-	if (argc == 4) {
+	if (argc >= 4) {
 		char *end;
 		timing_iterations = strtol(argv[3], &end, 10);
 
-		if (*end) {
+		if (*end || timing_iterations < 1) {
 			std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
 			return 0;
 		}
 	}
+
+	unsigned thread_count = default_thread_count();
+
+	if (argc >= 5) {
+		char *end;
+		const long value = strtol(argv[4], &end, 10);
+
+		if (*end || value < 1) {
+			std::cerr << "Please provide a number starting from 1, for the fourth argument." << std::endl;
+			return 0;
+		}
+		thread_count = static_cast<unsigned>(value);
+	}
+
+	// Optional table generated by generate_elm_table, read instead of computing ELM
+	std::unique_ptr<ELMTable> table;
+	const uint32_t *table_outputs = nullptr;
+
+	if (argc >= 6) {
+		try {
+			table = std::make_unique<ELMTable>(argv[5], slice != nullptr ? ELMTableAccess::Random : ELMTableAccess::Sequential);
+			table_outputs = table->evaluator<DefaultInterpretation>().outputs;
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Please provide an ELM table of the interpretation true,3,false, for the fifth argument." << std::endl;
+			return 0;
+		}
+	}
 	
-	int measured_time = 0;
+	std::unique_ptr<ProgressReporter> progress;
+	if (progress_options.enabled()) {
+		try {
+			progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
+
+	if (!checkpoint_options.path.empty()) {
+		if (slice != nullptr) {
+			std::cerr << "Please provide no checkpoint when testing a slice." << std::endl;
+			return 0;
+		}
+		if (timing_activated) {
+			std::cerr << "Please provide false for the second argument when using a checkpoint." << std::endl;
+			return 0;
+		}
+		try {
+			SweepCheckpoint checkpoint(checkpoint_options.path, static_cast<double>(checkpoint_options.interval_seconds),
+									   uint32_t{1} << elm_variant(DefaultInterpretation::id), counting_activated,
+									   checkpoint_options.resume);
+			const BijectivityCheckpoint hooks = checkpoint.hooks();
+			bijectivity_test<DefaultInterpretation>(counting_activated, timing_activated, thread_count, table_outputs, &hooks, progress.get());
+			checkpoint.remove();
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+		}
+		return 0;
+	}
+
+	long long measured_time = 0;
 	
 	if (timing_activated) {
 		for (int i = 0; i < timing_iterations; i++) {
 			auto start = high_resolution_clock::now();
-			bijectivity_test(counting_activated, timing_activated);
+			bijectivity_test<DefaultInterpretation>(counting_activated, timing_activated, thread_count, table_outputs, nullptr, progress.get(), slice);
 			auto end = high_resolution_clock::now();
 			measured_time += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 		}
@@ -137,7 +173,7 @@ int main(int argc, char *argv[]) {
 			std::cout << "Average time until bijectivity test finds one collision: " << measured_time / timing_iterations << std::endl;
 		}
 	} else {
-		bijectivity_test(counting_activated, timing_activated);
+		bijectivity_test<DefaultInterpretation>(counting_activated, timing_activated, thread_count, table_outputs, nullptr, progress.get(), slice);
     }
 	
 	return 0;
@@ -0,0 +1,363 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "file_io.hpp"
+#include "sweep.hpp"
+
+// Checkpoints of the bijectivity sweeps, so that a sweep of several hours can be interrupted and resumed with
+// exactly the same result. A checkpoint consists of two files:
+//
+//   path           SweepCheckpointHeader: cursor, collision counters and results of every variant. The cursor is a
+//                  position in the SweepSchedule of the sweep, whose order follows from the counting mode.
+//   path.bitmaps   two slots, each holding the bitmaps of all swept variants in ascending variant order
+//
+// A checkpoint writes the bitmaps into the slot not referenced by the current header and then replaces the header
+// by writing path.tmp and renaming it, so a crash at any time leaves a consistent checkpoint. Only regions that
+// changed since the slot was last written are written again. The sweep only pauses to copy these regions, all writing
+// happens on a separate thread while the sweep goes on. The copy is a snapshot of one pause and needs as much memory
+// as the changed regions, at most the size of the bitmaps; since ELM outputs are spread over all regions, a copy
+// spread over several pauses would never match a single cursor. A checkpoint that becomes due while the previous
+// one is still being written waits for the writer, the sweep does not.
+
+struct SweepCheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t variant_mask;
+    uint32_t counting_activated;
+    // Slot of path.bitmaps holding the bitmaps
+    uint32_t slot;
+    uint64_t next_chunk;
+    uint64_t collisions[ELM_VARIANT_COUNT];
+    uint32_t collision_found[ELM_VARIANT_COUNT];
+    uint32_t collision_input[ELM_VARIANT_COUNT];
+    uint32_t collision_output[ELM_VARIANT_COUNT];
+    // Checksum of all previous fields
+    uint64_t header_checksum;
+};
+
+constexpr char SWEEP_CHECKPOINT_MAGIC[8] = {'H', 'R', 'T', 'X', 'C', 'K', 'P', 'T'};
+constexpr uint32_t SWEEP_CHECKPOINT_VERSION = 2;
+constexpr uint64_t OUTPUT_BITMAP_REGION_BYTES = OUTPUT_BITMAP_REGION_WORDS * sizeof(uint64_t);
+
+inline uint64_t sweep_checkpoint_header_checksum(const SweepCheckpointHeader &header) {
+    uint64_t checksum = 0;
+    uint64_t field;
+    for (std::size_t i = 0; i < offsetof(SweepCheckpointHeader, header_checksum); i += sizeof(field)) {
+        std::memcpy(&field, reinterpret_cast<const uint8_t *>(&header) + i, sizeof(field));
+        checksum = mix64(checksum ^ field);
+    }
+    return checksum;
+}
+
+// Checkpoints of a sweep over the ELM variants in variant_mask every interval_seconds. Without resume a new
+// checkpoint is started at path, with resume the sweep continues from the checkpoint at path, which has to belong to
+// the same variants and counting mode. hooks() is passed to bijectivity_sweep or fused_bijectivity_sweep.
+class SweepCheckpoint {
+public:
+    SweepCheckpoint(std::string checkpoint_path, const double interval_seconds, const uint32_t variant_mask,
+                    const bool counting_activated, const bool resume)
+        : path(std::move(checkpoint_path)), interval(interval_seconds), mask(variant_mask),
+          counting(counting_activated), resuming(resume) {
+        for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+            if ((mask >> v & 1) != 0) {
+                variants.push_back(v);
+            }
+        }
+        for (std::vector<bool> &slot_stale : stale) {
+            slot_stale.assign(variants.size() * OutputBitmap::region_count, true);
+        }
+
+        const std::string bitmaps_path = path + ".bitmaps";
+        if (resume) {
+            bitmaps_fd = open(bitmaps_path.c_str(), O_RDWR);
+            if (bitmaps_fd < 0) {
+                throw std::runtime_error("Could not open " + bitmaps_path);
+            }
+            read_header();
+        } else {
+            bitmaps_fd = open(bitmaps_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (bitmaps_fd < 0) {
+                throw std::runtime_error("Could not create " + bitmaps_path);
+            }
+            if (ftruncate(bitmaps_fd, static_cast<off_t>(2 * variants.size() * ELM_DOMAIN_SIZE / 8)) != 0) {
+                close(bitmaps_fd);
+                throw std::runtime_error("Could not allocate " + bitmaps_path);
+            }
+        }
+
+        writer = std::thread([this] { write_jobs(); });
+    }
+
+    SweepCheckpoint(const SweepCheckpoint &) = delete;
+    SweepCheckpoint &operator=(const SweepCheckpoint &) = delete;
+
+    ~SweepCheckpoint() {
+        {
+            const std::lock_guard<std::mutex> lock(job_mutex);
+            closing = true;
+        }
+        job_changed.notify_all();
+        writer.join();
+        close(bitmaps_fd);
+    }
+
+    BijectivityCheckpoint hooks() {
+        BijectivityCheckpoint checkpoint;
+        checkpoint.restore = [this](std::vector<BijectivityResult> &results, const std::vector<OutputBitmap *> &bitmaps) {
+            return restore(results, bitmaps);
+        };
+        checkpoint.due = [this] {
+            return std::chrono::steady_clock::now() - last_save >= interval && writer_idle();
+        };
+        checkpoint.save = [this](const uint64_t next_chunk, const std::vector<BijectivityResult> &results,
+                                 const std::vector<OutputBitmap *> &bitmaps) {
+            save(next_chunk, results, bitmaps);
+        };
+        return checkpoint;
+    }
+
+    // Waits for the last write and deletes the checkpoint, called once the sweep has finished
+    void remove() {
+        wait_for_writer();
+        std::remove(path.c_str());
+        std::remove((path + ".bitmaps").c_str());
+    }
+
+private:
+    // Regions copied at a pause, written by the writer thread
+    struct Job {
+        SweepCheckpointHeader header{};
+        std::vector<uint64_t> positions;
+        std::unique_ptr<uint64_t[]> words;
+    };
+
+    std::string path;
+    std::chrono::duration<double> interval;
+    uint32_t mask;
+    bool counting;
+    bool resuming;
+    std::vector<int> variants;
+
+    int bitmaps_fd = -1;
+    SweepCheckpointHeader loaded{};
+    // Slot the next checkpoint writes to
+    uint32_t next_slot = 0;
+    // stale[s][k * region_count + r]: region r of the k-th swept variant differs from slot s
+    std::vector<bool> stale[2];
+    std::chrono::steady_clock::time_point last_save = std::chrono::steady_clock::now();
+
+    std::thread writer;
+    std::mutex job_mutex;
+    std::condition_variable job_changed;
+    Job job;
+    bool job_pending = false;
+    bool closing = false;
+    bool failed = false;
+
+    uint64_t region_position(const uint32_t slot, const std::size_t k, const uint64_t region) const {
+        return ((slot * variants.size() + k) * OutputBitmap::region_count + region) * OUTPUT_BITMAP_REGION_BYTES;
+    }
+
+    void read_header() {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            close(bitmaps_fd);
+            throw std::runtime_error("Could not open " + path);
+        }
+        const ssize_t read_count = pread(fd, &loaded, sizeof(loaded), 0);
+        close(fd);
+
+        std::string error;
+        if (read_count != static_cast<ssize_t>(sizeof(loaded)) ||
+            std::memcmp(loaded.magic, SWEEP_CHECKPOINT_MAGIC, sizeof(loaded.magic)) != 0 ||
+            loaded.version != SWEEP_CHECKPOINT_VERSION || loaded.header_checksum != sweep_checkpoint_header_checksum(loaded)) {
+            error = path + " is not a checkpoint of this version";
+        } else if (loaded.variant_mask != mask || (loaded.counting_activated != 0) != counting) {
+            error = path + " belongs to other interpretations or another counting mode";
+        }
+        if (!error.empty()) {
+            close(bitmaps_fd);
+            throw std::runtime_error(error);
+        }
+    }
+
+    uint64_t restore(std::vector<BijectivityResult> &results, const std::vector<OutputBitmap *> &bitmaps) {
+        if (!resuming) {
+            return 0;
+        }
+
+        for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+            results[v].collisions = loaded.collisions[v];
+            results[v].collision_found = loaded.collision_found[v] != 0;
+            results[v].collision_input = loaded.collision_input[v];
+            results[v].collision_output = loaded.collision_output[v];
+        }
+
+        std::vector<uint64_t> words(OUTPUT_BITMAP_REGION_WORDS);
+        for (std::size_t k = 0; k < variants.size(); k++) {
+            for (uint64_t r = 0; r < OutputBitmap::region_count; r++) {
+                read_at(bitmaps_fd, words.data(), OUTPUT_BITMAP_REGION_BYTES, region_position(loaded.slot, k, r));
+                bitmaps[variants[k]]->store_region(r, words.data());
+                stale[loaded.slot][k * OutputBitmap::region_count + r] = false;
+            }
+        }
+
+        next_slot = 1 - loaded.slot;
+        last_save = std::chrono::steady_clock::now();
+        return loaded.next_chunk;
+    }
+
+    // Called while the sweep is paused and the writer thread is idle (see due): copies the changed regions and hands
+    // them to the writer thread
+    void save(const uint64_t next_chunk, const std::vector<BijectivityResult> &results,
+              const std::vector<OutputBitmap *> &bitmaps) {
+        if (failed) {
+            return;
+        }
+
+        // Regions (k, r) that differ from the slot, all copied at this pause so that the slot matches the header
+        std::vector<std::pair<std::size_t, uint64_t>> regions;
+        for (std::size_t k = 0; k < variants.size(); k++) {
+            for (uint64_t r = 0; r < OutputBitmap::region_count; r++) {
+                const std::size_t i = k * OutputBitmap::region_count + r;
+                if (bitmaps[variants[k]]->take_dirty(r)) {
+                    stale[0][i] = stale[1][i] = true;
+                }
+                if (stale[next_slot][i]) {
+                    regions.emplace_back(k, r);
+                }
+            }
+        }
+
+        try {
+            job.words = std::make_unique_for_overwrite<uint64_t[]>(regions.size() * OUTPUT_BITMAP_REGION_WORDS);
+        } catch (const std::bad_alloc &) {
+            std::cerr << "Not enough memory to copy " << regions.size() << " bitmap regions of " << OUTPUT_BITMAP_REGION_BYTES
+                      << " bytes." << std::endl;
+            std::cerr << "Checkpoints are disabled." << std::endl;
+            failed = true;
+            return;
+        }
+        job.positions.clear();
+        for (std::size_t j = 0; j < regions.size(); j++) {
+            const auto [k, r] = regions[j];
+            bitmaps[variants[k]]->load_region(r, job.words.get() + j * OUTPUT_BITMAP_REGION_WORDS);
+            job.positions.push_back(region_position(next_slot, k, r));
+            stale[next_slot][k * OutputBitmap::region_count + r] = false;
+        }
+
+        SweepCheckpointHeader &header = job.header;
+        header = SweepCheckpointHeader{};
+        std::memcpy(header.magic, SWEEP_CHECKPOINT_MAGIC, sizeof(header.magic));
+        header.version = SWEEP_CHECKPOINT_VERSION;
+        header.variant_mask = mask;
+        header.counting_activated = counting;
+        header.slot = next_slot;
+        header.next_chunk = next_chunk;
+        for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+            header.collisions[v] = results[v].collisions;
+            header.collision_found[v] = results[v].collision_found;
+            header.collision_input[v] = results[v].collision_input;
+            header.collision_output[v] = results[v].collision_output;
+        }
+        header.header_checksum = sweep_checkpoint_header_checksum(header);
+
+        next_slot = 1 - next_slot;
+        {
+            const std::lock_guard<std::mutex> lock(job_mutex);
+            job_pending = true;
+        }
+        job_changed.notify_all();
+        last_save = std::chrono::steady_clock::now();
+    }
+
+    void wait_for_writer() {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        job_changed.wait(lock, [this] { return !job_pending; });
+    }
+
+    // The next checkpoint writes to the slot of the one before, so it is only due once that one is complete. A
+    // failed writer disables the checkpoints and no further pause is needed.
+    bool writer_idle() {
+        const std::lock_guard<std::mutex> lock(job_mutex);
+        return !job_pending && !failed;
+    }
+
+    void write_job() {
+        for (std::size_t i = 0; i < job.positions.size(); i++) {
+            write_at(bitmaps_fd, job.words.get() + i * OUTPUT_BITMAP_REGION_WORDS, OUTPUT_BITMAP_REGION_BYTES,
+                     job.positions[i]);
+        }
+        if (fdatasync(bitmaps_fd) != 0) {
+            throw std::runtime_error("Could not flush " + path + ".bitmaps");
+        }
+
+        // The header is replaced last, so it only references a slot that is completely written
+        const std::string temporary_path = path + ".tmp";
+        const int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Could not create " + temporary_path);
+        }
+        try {
+            write_at(fd, &job.header, sizeof(job.header), 0);
+            if (fsync(fd) != 0) {
+                throw std::runtime_error("Could not flush " + temporary_path);
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Could not replace " + path);
+        }
+    }
+
+    void write_jobs() {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        while (true) {
+            job_changed.wait(lock, [this] { return job_pending || closing; });
+            if (!job_pending) {
+                return;
+            }
+
+            lock.unlock();
+            bool written = true;
+            try {
+                write_job();
+            } catch (const std::exception &e) {
+                // The sweep goes on without checkpoints
+                std::cerr << e.what() << std::endl;
+                std::cerr << "Checkpoints are disabled." << std::endl;
+                written = false;
+            }
+            lock.lock();
+
+            failed = failed || !written;
+            job_pending = false;
+            job.words.reset();
+            job_changed.notify_all();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef DISTINGUISHED_POINTS_HPP
+#define DISTINGUISHED_POINTS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "progress.hpp"
+
+// Parallel collision search of van Oorschot and Wiener for a function f on the values [0, 2^bits). Every thread
+// walks x -> f(x) from a random starting point until it reaches a distinguished point, a value whose lowest
+// distinguished_bits bits are 0. Only the distinguished points are stored in a table shared by all threads, together
+// with the starting point and the length of the trail that reached them. If a second trail ends in the same point,
+// the two trails have merged: both are walked again from their starts, the longer one first advanced by the
+// difference of the lengths, until the next values are equal. The values before the merge collide.
+//
+// The table holds about (evaluations of f) / 2^distinguished_bits entries instead of one entry per evaluation, and the
+// threads only synchronize when they reach a distinguished point. A trail that is longer than 20 * 2^distinguished_bits
+// probably runs in a cycle without a distinguished point. The length of the cycle is measured by walking on until the
+// trail returns to its current value, and the point where the trail enters the cycle gives a collision as well. This
+// matters for functions with few outputs, whose trails almost never reach a distinguished point.
+//
+// With a fixed f, later trails mostly run into the same few large trees and find the same collisions again. Once the
+// table holds max_points points, it is cleared and the walk changes to x -> f(x) ^ s with a new random salt s. The
+// walk has exactly the collisions of f, but a different graph, so the following trails find new ones. This also
+// bounds the memory of the table.
+
+struct WalkCollision {
+    uint64_t a;
+    uint64_t b;
+    // f(a) = f(b)
+    uint64_t image;
+};
+
+struct WalkStatistics {
+    // Evaluations of f, including the ones for locating collisions
+    uint64_t steps = 0;
+    uint64_t distinguished_points = 0;
+    // Merges whose starting point lies on the other trail, they do not give a collision
+    uint64_t robin_hoods = 0;
+    // Trails that were started before the salt changed or run into no cycle within the maximum length
+    uint64_t abandoned_trails = 0;
+    // Trails without a distinguished point that were resolved by measuring their cycle
+    uint64_t cycles = 0;
+    uint64_t salt_changes = 0;
+    // Collisions that were found before and not passed to report again
+    uint64_t repeated_collisions = 0;
+    // Distinct collisions passed to report
+    uint64_t collisions = 0;
+    double seconds = 0;
+};
+
+// Searches until collision_count distinct collisions are found and calls report(collision, seconds) for each of them,
+// one call at a time, with the time since the start. f is called concurrently and has to map [0, 2^bits) into itself.
+// progress reports the evaluations of f as inputs and ELM calls if it is not null.
+template<typename F, typename R>
+WalkStatistics distinguished_point_search(const unsigned thread_count, const int bits, const int distinguished_bits,
+                                          const uint64_t max_points, const uint64_t collision_count, F &&f, R &&report,
+                                          ProgressReporter *progress = nullptr) {
+    struct Trail {
+        uint64_t start;
+        uint64_t length;
+    };
+
+    const uint64_t value_mask = bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+    const uint64_t distinguished_mask = (uint64_t{1} << distinguished_bits) - 1;
+    const uint64_t max_length = uint64_t{20} << distinguished_bits;
+
+    std::mutex table_mutex;
+    std::unordered_map<uint64_t, Trail> table;
+    std::set<std::pair<uint64_t, uint64_t>> found;
+    WalkStatistics statistics;
+    std::atomic<bool> stop{false};
+    // Only changed while table_mutex is held
+    std::atomic<uint64_t> salt{0};
+
+    const auto start_time = std::chrono::steady_clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    };
+
+    ProgressRun run(progress, {"Collision search", thread_count, 0, collision_count, 0, 0});
+
+    auto worker = [&](const unsigned thread_index) {
+        std::mt19937_64 rng(std::random_device{}() ^ static_cast<uint64_t>(std::random_device{}()) << 32);
+        uint64_t steps = 0, distinguished_points = 0, robin_hoods = 0, abandoned_trails = 0, cycles = 0;
+        uint64_t reported_steps = 0;
+
+        // Walks both trails again and returns whether they merge after different values
+        auto locate = [&](uint64_t a, uint64_t a_length, uint64_t b, uint64_t b_length, const uint64_t trail_salt,
+                          WalkCollision &collision) {
+            for (; a_length > b_length; a_length--, steps++) {
+                a = f(a) ^ trail_salt;
+            }
+            for (; b_length > a_length; b_length--, steps++) {
+                b = f(b) ^ trail_salt;
+            }
+            if (a == b) {
+                return false;
+            }
+            while (true) {
+                const uint64_t next_a = f(a) ^ trail_salt, next_b = f(b) ^ trail_salt;
+                steps += 2;
+                if (next_a == next_b) {
+                    collision = {a, b, next_a ^ trail_salt};
+                    return true;
+                }
+                a = next_a;
+                b = next_b;
+            }
+        };
+
+        auto report_collision = [&](const WalkCollision &collision) {
+            const std::lock_guard<std::mutex> lock(table_mutex);
+            if (stop.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if (!found.emplace(std::min(collision.a, collision.b), std::max(collision.a, collision.b)).second) {
+                statistics.repeated_collisions++;
+                return;
+            }
+
+            statistics.collisions++;
+            run.add(thread_index, 0, 0, 1);
+            report(collision, elapsed());
+            if (statistics.collisions >= collision_count) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        while (!stop.load(std::memory_order_relaxed)) {
+            run.add(thread_index, steps - reported_steps, steps - reported_steps, 0);
+            reported_steps = steps;
+
+            const uint64_t trail_salt = salt.load(std::memory_order_relaxed);
+            const uint64_t start = rng() & value_mask;
+            uint64_t x = start, length = 0;
+
+            do {
+                x = f(x) ^ trail_salt;
+                length++;
+            } while ((x & distinguished_mask) != 0 && length < max_length);
+            steps += length;
+
+            WalkCollision collision;
+
+            if ((x & distinguished_mask) != 0) {
+                uint64_t y = f(x) ^ trail_salt, cycle_length = 1;
+                for (; y != x && cycle_length < max_length; cycle_length++) {
+                    y = f(y) ^ trail_salt;
+                }
+                steps += cycle_length;
+
+                if (y != x) {
+                    abandoned_trails++;
+                    continue;
+                }
+                cycles++;
+
+                // The same trail once more, started cycle_length steps ahead, meets it where it enters the cycle
+                if (locate(start, length + cycle_length, start, length, trail_salt, collision)) {
+                    report_collision(collision);
+                }
+                continue;
+            }
+            distinguished_points++;
+
+            Trail other;
+            {
+                const std::lock_guard<std::mutex> lock(table_mutex);
+                if (trail_salt != salt.load(std::memory_order_relaxed)) {
+                    abandoned_trails++;
+                    continue;
+                }
+                const auto [it, inserted] = table.try_emplace(x, Trail{start, length});
+                if (inserted) {
+                    if (table.size() >= max_points) {
+                        table.clear();
+                        salt.store(rng() & value_mask, std::memory_order_relaxed);
+                        statistics.salt_changes++;
+                    }
+                    continue;
+                }
+                other = it->second;
+            }
+
+            if (!locate(start, length, other.start, other.length, trail_salt, collision)) {
+                robin_hoods++;
+                continue;
+            }
+            report_collision(collision);
+        }
+
+        run.add(thread_index, steps - reported_steps, steps - reported_steps, 0);
+        const std::lock_guard<std::mutex> lock(table_mutex);
+        statistics.steps += steps;
+        statistics.distinguished_points += distinguished_points;
+        statistics.robin_hoods += robin_hoods;
+        statistics.abandoned_trails += abandoned_trails;
+        statistics.cycles += cycles;
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    statistics.seconds = elapsed();
+    return statistics;
+}
+
+#endif
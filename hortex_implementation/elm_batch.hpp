@@ -0,0 +1,245 @@
+#ifndef ELM_BATCH_HPP
+#define ELM_BATCH_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "fast_exp2.hpp"
+#include "hortex.hpp"
+
+// Batch evaluation of ELM. W inputs are processed together in the lanes of one vector register (W = 4 for AVX2,
+// W = 8 for AVX-512). Every lane runs its own n + 2 iterations; lanes that are finished are masked out while the
+// others keep iterating. The floating point operations are the same as in the scalar ELM, so the outputs are
+// bit-identical to ELM<I>.
+//
+// With AVX-512, exp2 is evaluated in the lanes with the kernel of fast_exp2.hpp. Lanes whose rounding it cannot
+// certify fall back to the system exp2 of the scalar ELM, so the results stay identical. With AVX2 every lane calls
+// the system exp2. All other steps (starting values, fLM, modf, binary32, combine) are vectorized.
+
+enum class ELMBackend {
+    Scalar,
+    AVX2,
+    AVX512
+};
+
+inline const char *backend_name(const ELMBackend backend) {
+    switch (backend) {
+        case ELMBackend::AVX2:
+            return "avx2";
+        case ELMBackend::AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+// The avx2 and avx512f targets imply FMA, which GCC would otherwise contract into fLM and the starting values. The
+// scalar reference in hortex.hpp is compiled without contraction as well, so both agree under any compiler flags.
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+template<int W>
+struct Lanes {
+    typedef double f64 __attribute__((vector_size(8 * W)));
+    typedef float f32 __attribute__((vector_size(4 * W)));
+    typedef int64_t i64 __attribute__((vector_size(8 * W)));
+    typedef int32_t i32 __attribute__((vector_size(4 * W)));
+    typedef uint32_t u32 __attribute__((vector_size(4 * W)));
+};
+
+template<typename I>
+void ELM_batch_scalar(const uint32_t *in, uint32_t *out, const std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        out[i] = ELM<I>(in[i]);
+    }
+}
+
+// Outputs of both multiplier settings of one ELM variant, given the exp2 of the first iteration. Null outputs are
+// skipped.
+template<bool Improved, int CS>
+inline void ELM_fused_chain(const ELMParameters &p, const double first, uint32_t *inside, uint32_t *outside) {
+    using Inside = Interpretation<Improved, CS, false, true>;
+    using Outside = Interpretation<Improved, CS, true, true>;
+
+    if (inside == nullptr && outside == nullptr) {
+        return;
+    }
+
+    double gamma = first;
+    if constexpr (Improved) {
+        double int_part;
+        gamma = std::modf(first, &int_part);
+    }
+
+    for (int i = 0; i < p.n; i++) {
+        gamma = fELM<Inside>(p.eta, gamma, p.k);
+    }
+    const double w1_gamma = gamma;
+
+    gamma = fELM<Inside>(p.eta, gamma, p.k);
+    const uint32_t w2 = binary32(gamma);
+
+    if (inside != nullptr) {
+        *inside = std::rotl(ELM_w1<Inside>(w1_gamma), 17) ^ w2;
+    }
+    if (outside != nullptr) {
+        *outside = std::rotl(ELM_w1<Outside>(w1_gamma), 17) ^ w2;
+    }
+}
+
+template<int CS>
+void ELM_fused_batch_scalar(const uint32_t *in, uint32_t *const out[4], const std::size_t begin, const std::size_t count) {
+    auto at = [&](uint32_t *outputs, const std::size_t i) {
+        return outputs == nullptr ? nullptr : outputs + i;
+    };
+
+    for (std::size_t i = begin; i < count; i++) {
+        const ELMParameters p = ELM_parameters<Interpretation<false, CS, false, true>>(in[i]);
+        // The first exp2 does not depend on use_improved_elm
+        const double first = std::exp2(p.k - fLM(p.eta, p.gamma));
+
+        ELM_fused_chain<false, CS>(p, first, at(out[0], i), at(out[1], i));
+        ELM_fused_chain<true, CS>(p, first, at(out[2], i), at(out[3], i));
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace elm_avx2 {
+
+// With 4 lanes the vector exp2 measured no faster than the system exp2 per lane
+constexpr bool use_exp2_lanes = false;
+
+// a * b + c with one rounding
+[[gnu::always_inline]] inline Lanes<4>::f64 fma_lanes(const Lanes<4>::f64 &a, const Lanes<4>::f64 &b, const Lanes<4>::f64 &c) {
+    return reinterpret_cast<Lanes<4>::f64>(_mm256_fmadd_pd(reinterpret_cast<__m256d>(a), reinterpret_cast<__m256d>(b),
+                                                           reinterpret_cast<__m256d>(c)));
+}
+
+// EXP2_TABLE[index[j]] of all lanes
+[[gnu::always_inline]] inline void gather_exp2_table(const Lanes<4>::i64 &index, Lanes<4>::f64 &t_hi, Lanes<4>::f64 &t_lo) {
+    const __m256i offsets = reinterpret_cast<__m256i>(index + index);
+    t_hi = reinterpret_cast<Lanes<4>::f64>(_mm256_i64gather_pd(&EXP2_TABLE[0][0], offsets, 8));
+    t_lo = reinterpret_cast<Lanes<4>::f64>(_mm256_i64gather_pd(&EXP2_TABLE[0][1], offsets, 8));
+}
+
+// Bit j is set if lane j is NaN
+[[gnu::always_inline]] inline unsigned nan_lanes(const Lanes<4>::f64 &v) {
+    const __m256d x = reinterpret_cast<__m256d>(v);
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(x, x, _CMP_UNORD_Q)));
+}
+
+#include "elm_lanes.inc"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace elm_avx512 {
+
+#ifdef HORTEX_LIBM_EXP2
+constexpr bool use_exp2_lanes = false;
+#else
+constexpr bool use_exp2_lanes = true;
+#endif
+
+[[gnu::always_inline]] inline Lanes<8>::f64 fma_lanes(const Lanes<8>::f64 &a, const Lanes<8>::f64 &b, const Lanes<8>::f64 &c) {
+    return reinterpret_cast<Lanes<8>::f64>(_mm512_fmadd_pd(reinterpret_cast<__m512d>(a), reinterpret_cast<__m512d>(b),
+                                                           reinterpret_cast<__m512d>(c)));
+}
+
+[[gnu::always_inline]] inline void gather_exp2_table(const Lanes<8>::i64 &index, Lanes<8>::f64 &t_hi, Lanes<8>::f64 &t_lo) {
+    const __m512i offsets = reinterpret_cast<__m512i>(index + index);
+    // The masked form avoids a spurious -Wmaybe-uninitialized of the unmasked intrinsic in GCC 12
+    const __m512d zero = _mm512_setzero_pd();
+    t_hi = reinterpret_cast<Lanes<8>::f64>(_mm512_mask_i64gather_pd(zero, 0xFF, offsets, &EXP2_TABLE[0][0], 8));
+    t_lo = reinterpret_cast<Lanes<8>::f64>(_mm512_mask_i64gather_pd(zero, 0xFF, offsets, &EXP2_TABLE[0][1], 8));
+}
+
+[[gnu::always_inline]] inline unsigned nan_lanes(const Lanes<8>::f64 &v) {
+    const __m512d x = reinterpret_cast<__m512d>(v);
+    return _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q);
+}
+
+#include "elm_lanes.inc"
+}
+#pragma GCC pop_options
+
+#endif
+
+#pragma GCC pop_options
+
+// Best backend supported by the CPU, determined once at runtime
+inline ELMBackend detected_backend() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const ELMBackend backend = __builtin_cpu_supports("avx512f") ? ELMBackend::AVX512
+                                      : __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? ELMBackend::AVX2
+                                      : ELMBackend::Scalar;
+    return backend;
+#else
+    return ELMBackend::Scalar;
+#endif
+}
+
+inline bool backend_supported(const ELMBackend backend) {
+    switch (backend) {
+        case ELMBackend::AVX512:
+            return detected_backend() == ELMBackend::AVX512;
+        case ELMBackend::AVX2:
+            return detected_backend() != ELMBackend::Scalar;
+        default:
+            return true;
+    }
+}
+
+// out[i] = ELM<I>(in[i]) for i < count, using the given backend
+template<typename I>
+void ELM_batch(const uint32_t *in, uint32_t *out, const std::size_t count, const ELMBackend backend) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (backend == ELMBackend::AVX512) {
+        elm_avx512::ELM_batch_lanes<I, 8>(in, out, count);
+        return;
+    }
+    if (backend == ELMBackend::AVX2) {
+        elm_avx2::ELM_batch_lanes<I, 4>(in, out, count);
+        return;
+    }
+#endif
+    ELM_batch_scalar<I>(in, out, count);
+}
+
+template<typename I>
+void ELM_batch(const uint32_t *in, uint32_t *out, const std::size_t count) {
+    ELM_batch<I>(in, out, count, detected_backend());
+}
+
+// ELM of the four interpretations with constants setting CS in one pass: out[improved << 1 | multiplier_is_outside]
+// receives the outputs of that variant, null entries are skipped. The variants share the starting values and the
+// first exp2, and both multiplier settings share all iterations, since they only differ in w1.
+template<int CS>
+void ELM_fused_batch(const uint32_t *in, uint32_t *const out[4], const std::size_t count, const ELMBackend backend) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (backend == ELMBackend::AVX512) {
+        elm_avx512::ELM_fused_batch_lanes<CS, 8>(in, out, count);
+        return;
+    }
+    if (backend == ELMBackend::AVX2) {
+        elm_avx2::ELM_fused_batch_lanes<CS, 4>(in, out, count);
+        return;
+    }
+#endif
+    ELM_fused_batch_scalar<CS>(in, out, 0, count);
+}
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef ELM_TABLE_HPP
+#define ELM_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file_io.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Precomputed table of all 2^32 outputs of ELM<I>. The file consists of
+//
+//   header   4096 bytes, see ELMTableHeader
+//   outputs  2^32 x uint32 in native byte order, outputs[x] = ELM<I>(x)
+//
+// and is mapped read-only into memory, so that every ELM call of fFunction, hortex or a sweep becomes one load.
+// The header stores the interpretation the table was generated for and a checksum over all entries. The checksum is
+// a sum of independent terms, so it is computed on all threads in any order.
+
+struct ELMTableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t interpretation;
+    uint64_t entry_count;
+    uint64_t table_position;
+    uint64_t table_checksum;
+    // Checksum of all previous fields
+    uint64_t header_checksum;
+};
+
+constexpr char ELM_TABLE_MAGIC[8] = {'H', 'R', 'T', 'X', 'E', 'L', 'M', 'T'};
+constexpr uint32_t ELM_TABLE_VERSION = 1;
+constexpr uint64_t ELM_TABLE_HEADER_SIZE = 4096;
+
+// Contribution of the entry outputs[x] = y to the table checksum
+inline uint64_t elm_table_term(const uint32_t x, const uint32_t y) {
+    return mix64(uint64_t{x} << 32 | y);
+}
+
+inline uint64_t elm_table_header_checksum(const ELMTableHeader &header) {
+    uint64_t checksum = 0;
+    uint64_t field;
+    for (std::size_t i = 0; i < offsetof(ELMTableHeader, header_checksum); i += sizeof(field)) {
+        std::memcpy(&field, reinterpret_cast<const uint8_t *>(&header) + i, sizeof(field));
+        checksum = mix64(checksum ^ field);
+    }
+    return checksum;
+}
+
+// ELM evaluated by a lookup in a mapped table, can be passed to fFunction, Hortex and hortex in place of
+// ComputedELM<I>. Obtained from ELMTable::evaluator, which checks the interpretation.
+template<typename I>
+struct TableELM {
+    const uint32_t *outputs;
+
+    uint32_t operator()(const uint32_t x) const {
+        return outputs[x];
+    }
+};
+
+// Writes the table of ELM<I> to path with thread_count threads
+template<typename I>
+void generate_elm_table(const std::string &path, const unsigned thread_count) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not create " + path);
+    }
+
+    std::vector<ThreadCounter> checksums(thread_count);
+
+    try {
+        sweep_elm<I>(thread_count, [&](const unsigned thread_index, const uint32_t *inputs, const uint32_t *outputs,
+                                       const uint32_t count) {
+            uint64_t checksum = 0;
+            for (uint32_t j = 0; j < count; j++) {
+                checksum += elm_table_term(inputs[j], outputs[j]);
+            }
+            checksums[thread_index].value += checksum;
+
+            write_at(fd, outputs, count * sizeof(uint32_t), ELM_TABLE_HEADER_SIZE + uint64_t{inputs[0]} * sizeof(uint32_t));
+            return true;
+        }, nullptr, nullptr, SweepOrder::CostDescending);
+
+        ELMTableHeader header{};
+        std::memcpy(header.magic, ELM_TABLE_MAGIC, sizeof(header.magic));
+        header.version = ELM_TABLE_VERSION;
+        header.interpretation = I::id;
+        header.entry_count = ELM_DOMAIN_SIZE;
+        header.table_position = ELM_TABLE_HEADER_SIZE;
+        for (const ThreadCounter &checksum : checksums) {
+            header.table_checksum += checksum.value;
+        }
+        header.header_checksum = elm_table_header_checksum(header);
+
+        // The header is written last, so an interrupted generation leaves a file that is rejected when loading
+        std::vector<uint8_t> header_block(ELM_TABLE_HEADER_SIZE);
+        std::memcpy(header_block.data(), &header, sizeof(header));
+        write_at(fd, header_block.data(), header_block.size(), 0);
+
+        if (fsync(fd) != 0) {
+            throw std::runtime_error("Could not flush " + path);
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+// Access pattern of the table, passed to madvise
+enum class ELMTableAccess {
+    // Hashing and random inputs
+    Random,
+    // Sweeps over the inputs in ascending order
+    Sequential
+};
+
+// Read-only mapping of a table file. The header, the file size and the interpretation are always checked, the
+// checksum over all 2^32 entries only on request because it reads the entire 16 GiB.
+class ELMTable {
+public:
+    explicit ELMTable(const std::string &path, const ELMTableAccess access = ELMTableAccess::Random) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        struct stat status{};
+        fstat(fd, &status);
+        size = static_cast<std::size_t>(status.st_size);
+
+        if (size != ELM_TABLE_HEADER_SIZE + ELM_DOMAIN_SIZE * sizeof(uint32_t)) {
+            close(fd);
+            throw std::runtime_error(path + " is not a complete ELM table");
+        }
+
+        data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Could not map " + path);
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, ELM_TABLE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != ELM_TABLE_VERSION || header.header_checksum != elm_table_header_checksum(header) ||
+            header.entry_count != ELM_DOMAIN_SIZE || header.table_position != ELM_TABLE_HEADER_SIZE) {
+            munmap(data, size);
+            throw std::runtime_error(path + " is not an ELM table of this version or its header is damaged");
+        }
+
+        outputs = reinterpret_cast<const uint32_t *>(static_cast<const uint8_t *>(data) + header.table_position);
+
+        // Transparent huge pages cut the TLB misses of random lookups, they are only a hint and may be unavailable
+        // for file mappings
+        madvise(data, size, MADV_HUGEPAGE);
+        madvise(data, size, access == ELMTableAccess::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+    }
+
+    ELMTable(const ELMTable &) = delete;
+    ELMTable &operator=(const ELMTable &) = delete;
+
+    ~ELMTable() {
+        munmap(data, size);
+    }
+
+    // Interpretation the table was generated for. ELM does not depend on use_pseudocode_arx.
+    int interpretation() const {
+        return static_cast<int>(header.interpretation);
+    }
+
+    // Lookup handle for ELM<I>, throws if the table belongs to another ELM variant. A few entries are compared with
+    // ELM<I> to catch tables whose entries were damaged or generated by a different implementation.
+    template<typename I>
+    TableELM<I> evaluator() const {
+        if ((interpretation() | 1) != (I::id | 1)) {
+            throw std::runtime_error("The ELM table was generated for another interpretation");
+        }
+        for (uint64_t x = 0; x < ELM_DOMAIN_SIZE; x += 0x10001001) {
+            if (outputs[x] != ELM<I>(static_cast<uint32_t>(x))) {
+                throw std::runtime_error("The ELM table does not match ELM of its interpretation");
+            }
+        }
+        return TableELM<I>{outputs};
+    }
+
+    // Recomputes the checksum over all entries with thread_count threads
+    bool verify_checksum(const unsigned thread_count) const {
+        std::vector<ThreadCounter> checksums(thread_count);
+        parallel_ranges(thread_count, ELM_DOMAIN_SIZE, [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+            uint64_t checksum = 0;
+            for (uint64_t x = begin; x < end; x++) {
+                checksum += elm_table_term(static_cast<uint32_t>(x), outputs[x]);
+            }
+            checksums[t].value = checksum;
+        });
+
+        uint64_t checksum = 0;
+        for (const ThreadCounter &counter : checksums) {
+            checksum += counter.value;
+        }
+        return checksum == header.table_checksum;
+    }
+
+private:
+    ELMTableHeader header{};
+    void *data = nullptr;
+    std::size_t size = 0;
+    const uint32_t *outputs = nullptr;
+};
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef EQUIVALENCE_HPP
+#define EQUIVALENCE_HPP
+
+#include <algorithm>
+#include <bitset>
+#include <cfenv>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "arguments.hpp"
+#include "elm_batch.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "hortex_many.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
+
+// Differential comparison of the optimized ELM, fFunction and hortex paths with the reference, the scalar ELM<I> of
+// hortex.hpp and the sponge as specified on top of it. A candidate is any implementation under test: an ELM_batch
+// backend, the fused batch, an ELM table, the batched fFunction of hortex_many or the incremental Hortex context.
+//
+//   - ELM: all 2^32 inputs (or every stride-th chunk), the chunks handed out by cost like the sweeps. The reference
+//     outputs of a chunk are computed once and compared with every candidate.
+//   - fFunction: structured states (zero, all ones, every single bit, every word set to extreme x_left values) and
+//     random states.
+//   - hortex: structured messages of every length up to a few blocks and random messages of random length.
+//
+// For every candidate the first differing input is kept, i.e. the smallest x or the first state or message in the
+// order of the test set. For states and messages the ELM calls of the reference evaluation are then replayed with the
+// ELM of the candidate to find the first ELM input that is evaluated differently.
+//
+// The comparison is only meaningful in the floating-point environment the reference was defined in, which
+// floating_point_environment_problems checks first.
+
+// Differences found from the IEEE 754 defaults that ELM relies on: rounding to nearest, no flushing of subnormals,
+// double evaluation without excess precision, one rounding per operation (no FMA contraction by the compiler flags),
+// and the binary32 conversions of ieee754_test.cpp
+inline std::vector<std::string> floating_point_environment_problems() {
+    std::vector<std::string> problems;
+    if (std::fegetround() != FE_TONEAREST) {
+        problems.emplace_back("the rounding mode is not round to nearest");
+    }
+    if (FLT_EVAL_METHOD != 0) {
+        problems.emplace_back("FLT_EVAL_METHOD is " + std::to_string(FLT_EVAL_METHOD) + ", double arithmetic may use excess precision");
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    // Flush to zero (bit 15) and denormals are zero (bit 6) of MXCSR
+    if ((_mm_getcsr() & 0x8040) != 0) {
+        problems.emplace_back("MXCSR flushes subnormals (FTZ or DAZ is set)");
+    }
+#endif
+
+    // The starting values of x = 87 * 2^20 + 87 * 2^4 + 7 (constants_setting 3, exact bits, since ELM_parameters may be
+    // contracted as well) give a different exponent of fELM if k - eta * gamma * (1 - gamma) is evaluated with an FMA.
+    // The intermediate products of the expected value are rounded through volatile.
+    const volatile double eta = 0x1.005700570057p+1, gamma = 0x1.5c15c15c15c16p-6, k = 0x1.4f40da740da74p+3;
+    const volatile double eta_gamma = eta * gamma;
+    const volatile double logistic = eta_gamma * (1.0 - gamma);
+    if (fELM_exponent(eta, gamma, k) != k - logistic) {
+#ifdef __FMA__
+        problems.emplace_back("the reference ELM was compiled with FMA contraction (__FMA__ is defined and fp-contract is not off), its outputs depend on the compiler flags");
+#else
+        problems.emplace_back("the reference ELM does not round k - eta * gamma * (1 - gamma) once per operation");
+#endif
+    }
+
+    const float one_up = std::nextafterf(1.0f, 2.0f);
+    const double halfway = (1.0 + static_cast<double>(one_up)) / 2.0;
+    const volatile double subnormal = static_cast<double>(std::numeric_limits<float>::denorm_min());
+    const volatile double above_float_max = static_cast<double>(std::numeric_limits<float>::max()) * 2.0;
+    if (binary32(halfway) != std::bit_cast<uint32_t>(1.0f)) {
+        problems.emplace_back("binary32 does not round ties to even");
+    }
+    if (binary32(std::nextafter(halfway, 2.0)) != std::bit_cast<uint32_t>(one_up)) {
+        problems.emplace_back("binary32 does not round above the halfway point up");
+    }
+    if (binary32(subnormal) != 1) {
+        problems.emplace_back("binary32 does not keep the smallest subnormal");
+    }
+    if (binary32(above_float_max) != std::bit_cast<uint32_t>(std::numeric_limits<float>::infinity())) {
+        problems.emplace_back("binary32 does not overflow to infinity");
+    }
+    if (std::exp2(-1074.0) != std::numeric_limits<double>::denorm_min()) {
+        problems.emplace_back("exp2 does not reach the smallest subnormal double");
+    }
+    return problems;
+}
+
+// An ELM implementation under test: out[i] = ELM(in[i]) for i < count
+template<typename I>
+struct ELMCandidate {
+    std::string name;
+    std::function<void(const uint32_t *, uint32_t *, std::size_t)> batch;
+};
+
+// An fFunction implementation under test: states[i] = fFunction(states[i]) for i < count. elm evaluates single inputs
+// the way the candidate does, to locate a difference.
+template<typename I>
+struct StateCandidate {
+    std::string name;
+    std::function<void(State *, std::size_t)> apply;
+    std::function<uint32_t(uint32_t)> elm;
+};
+
+// A hortex implementation under test: the digests of count messages, see hortex_many
+template<typename I>
+struct MessageCandidate {
+    std::string name;
+    std::function<void(const HortexMessage *, std::size_t, uint8_t *)> hash;
+    std::function<uint32_t(uint32_t)> elm;
+};
+
+// ELM of one input with a batch backend. The input fills a whole batch, so the vector path is taken.
+template<typename I>
+uint32_t backend_elm(const uint32_t x, const ELMBackend backend) {
+    uint32_t in[HORTEX_MANY_LANES], out[HORTEX_MANY_LANES];
+    std::fill(in, in + HORTEX_MANY_LANES, x);
+    ELM_batch<I>(in, out, HORTEX_MANY_LANES, backend);
+    return out[0];
+}
+
+template<typename I>
+bool table_matches(const ELMTable *table) {
+    return table != nullptr && (table->interpretation() | 1) == (I::id | 1);
+}
+
+// Backends of this CPU
+inline std::vector<ELMBackend> supported_backends() {
+    std::vector<ELMBackend> backends;
+    for (const ELMBackend backend : {ELMBackend::Scalar, ELMBackend::AVX2, ELMBackend::AVX512}) {
+        if (backend_supported(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+template<typename I>
+std::vector<ELMCandidate<I>> elm_candidates(const ELMTable *table) {
+    std::vector<ELMCandidate<I>> candidates;
+    for (const ELMBackend backend : supported_backends()) {
+        // ELM_batch of the scalar backend is the reference loop itself
+        if (backend != ELMBackend::Scalar) {
+            candidates.push_back({std::string("ELM_batch ") + backend_name(backend), [backend](const uint32_t *in, uint32_t *out, const std::size_t count) {
+                ELM_batch<I>(in, out, count, backend);
+            }});
+        }
+        candidates.push_back({std::string("ELM_fused_batch ") + backend_name(backend), [backend](const uint32_t *in, uint32_t *out, const std::size_t count) {
+            uint32_t *outputs[4] = {};
+            outputs[(I::use_improved_elm ? 2 : 0) | (I::multiplier_is_outside ? 1 : 0)] = out;
+            ELM_fused_batch<I::constants_setting>(in, outputs, count, backend);
+        }});
+    }
+    if (table_matches<I>(table)) {
+        const TableELM<I> elm = table->evaluator<I>();
+        candidates.push_back({"table", [elm](const uint32_t *in, uint32_t *out, const std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                out[i] = elm(in[i]);
+            }
+        }});
+    }
+    return candidates;
+}
+
+template<typename I>
+std::vector<StateCandidate<I>> state_candidates(const ELMTable *table) {
+    std::vector<StateCandidate<I>> candidates;
+    const auto computed = [](const uint32_t x) { return ELM<I>(x); };
+    candidates.push_back({"std::bitset", [](State *states, const std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            states[i] = to_state(fFunction<I>(to_bitset(states[i])));
+        }
+    }, computed});
+    for (const ELMBackend backend : supported_backends()) {
+        candidates.push_back({std::string("fFunction_many ") + backend_name(backend), [backend](State *states, const std::size_t count) {
+            for (std::size_t i = 0; i < count; i += HORTEX_MANY_LANES) {
+                fFunction_many<I>(states + i, static_cast<int>(std::min<std::size_t>(HORTEX_MANY_LANES, count - i)), backend);
+            }
+        }, [backend](const uint32_t x) { return backend_elm<I>(x, backend); }});
+    }
+    if (table_matches<I>(table)) {
+        const TableELM<I> elm = table->evaluator<I>();
+        candidates.push_back({"table", [elm](State *states, const std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                states[i] = fFunction<I>(states[i], elm);
+            }
+        }, elm});
+    }
+    return candidates;
+}
+
+template<typename I>
+std::vector<MessageCandidate<I>> message_candidates(const ELMTable *table) {
+    std::vector<MessageCandidate<I>> candidates;
+    const auto computed = [](const uint32_t x) { return ELM<I>(x); };
+    candidates.push_back({"hortex", [](const HortexMessage *messages, const std::size_t count, uint8_t *digests) {
+        for (std::size_t i = 0; i < count; i++) {
+            hortex<I>(messages[i].data, messages[i].len, digests + Hortex<I>::digest_size * i);
+        }
+    }, computed});
+    // Hortex fed in pieces of 1, 2, ..., 13 bytes, so every buffering path of update is taken
+    candidates.push_back({"Hortex pieces", [](const HortexMessage *messages, const std::size_t count, uint8_t *digests) {
+        for (std::size_t i = 0; i < count; i++) {
+            Hortex<I> ctx;
+            for (std::size_t offset = 0, piece = 1; offset < messages[i].len; offset += piece, piece = piece % 13 + 1) {
+                ctx.update(messages[i].data + offset, std::min(piece, messages[i].len - offset));
+            }
+            ctx.final(digests + Hortex<I>::digest_size * i);
+        }
+    }, computed});
+    for (const ELMBackend backend : supported_backends()) {
+        candidates.push_back({std::string("hortex_many ") + backend_name(backend), [backend](const HortexMessage *messages, const std::size_t count, uint8_t *digests) {
+            hortex_many<I>(messages, count, digests, backend);
+        }, [backend](const uint32_t x) { return backend_elm<I>(x, backend); }});
+    }
+    if (table_matches<I>(table)) {
+        const TableELM<I> elm = table->evaluator<I>();
+        candidates.push_back({"table", [elm](const HortexMessage *messages, const std::size_t count, uint8_t *digests) {
+            for (std::size_t i = 0; i < count; i++) {
+                hortex<I>(messages[i].data, messages[i].len, digests + Hortex<I>::digest_size * i, elm);
+            }
+        }, elm});
+    }
+    return candidates;
+}
+
+// First difference of one candidate: the smallest differing x, or the index of the first differing state or message
+struct EquivalenceDifference {
+    bool found = false;
+    uint64_t index = 0;
+
+    void add(const uint64_t i) {
+        if (!found || i < index) {
+            found = true;
+            index = i;
+        }
+    }
+};
+
+// Compares every candidate with ELM<I> on every stride-th chunk. fingerprint receives an order-independent checksum
+// of all reference outputs, to compare builds with different compilers or flags.
+template<typename I>
+std::vector<EquivalenceDifference> verify_elm(const std::vector<ELMCandidate<I>> &candidates, const unsigned thread_count,
+                                              const uint64_t stride, uint64_t &fingerprint, ProgressReporter *progress = nullptr) {
+    const SweepSchedule schedule(SweepOrder::CostDescending, stride);
+    std::vector<std::vector<EquivalenceDifference>> differences(thread_count, std::vector<EquivalenceDifference>(candidates.size()));
+    std::vector<ThreadCounter> fingerprints(thread_count);
+    std::vector<std::vector<uint32_t>> inputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+    std::vector<std::vector<uint32_t>> references(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+    std::vector<std::vector<uint32_t>> outputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+
+    ProgressRun run(progress, {"ELM " + interpretation_name(I::id, false), thread_count, schedule.size() * SWEEP_CHUNK_SIZE});
+
+    sweep_chunks(thread_count, schedule, [&](const unsigned t, const uint64_t chunk_start) {
+        uint64_t sum = 0;
+        for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+            inputs[t][j] = static_cast<uint32_t>(chunk_start + j);
+            references[t][j] = ELM<I>(inputs[t][j]);
+            sum += elm_table_term(inputs[t][j], references[t][j]);
+        }
+        fingerprints[t].value += sum;
+
+        for (std::size_t c = 0; c < candidates.size(); c++) {
+            candidates[c].batch(inputs[t].data(), outputs[t].data(), SWEEP_CHUNK_SIZE);
+            for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+                if (outputs[t][j] != references[t][j]) {
+                    differences[t][c].add(inputs[t][j]);
+                    break;
+                }
+            }
+        }
+        run.add(t, SWEEP_CHUNK_SIZE, SWEEP_CHUNK_SIZE * (candidates.size() + 1), 0);
+        return true;
+    }, nullptr);
+
+    fingerprint = 0;
+    for (const ThreadCounter &counter : fingerprints) {
+        fingerprint += counter.value;
+    }
+    std::vector<EquivalenceDifference> first(candidates.size());
+    for (const std::vector<EquivalenceDifference> &thread_differences : differences) {
+        for (std::size_t c = 0; c < candidates.size(); c++) {
+            if (thread_differences[c].found) {
+                first[c].add(thread_differences[c].index);
+            }
+        }
+    }
+    return first;
+}
+
+// Zero, all ones, every single bit, every word set to the first and last input of the cheapest and the most expensive
+// x_left bucket, then random_count random states
+inline std::vector<State> equivalence_states(const std::size_t random_count, const uint64_t seed) {
+    std::vector<State> states;
+    states.push_back(State{});
+    State ones;
+    ones.fill(0xFFFFFFFF);
+    states.push_back(ones);
+    for (int bit = 0; bit < 256; bit++) {
+        State state{};
+        state[bit / 32] = uint32_t{1} << (bit % 32);
+        states.push_back(state);
+    }
+    for (const uint32_t value : {0x00000000u, 0x000FFFFFu, 0xFFF00000u, 0xFFFFFFFFu}) {
+        for (int word = 0; word < 8; word++) {
+            State state{};
+            state[word] = value;
+            states.push_back(state);
+            state.fill(value);
+            state[word] = ~value;
+            states.push_back(state);
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = 0; i < random_count; i++) {
+        State state;
+        for (uint32_t &word : state) {
+            word = static_cast<uint32_t>(rng());
+        }
+        states.push_back(state);
+    }
+    return states;
+}
+
+// Structured messages of 0 to 4 blocks plus one byte (all zero, all 0xFF and counting bytes), then random_count
+// random messages of up to 256 bytes. The bytes live in storage.
+inline std::vector<HortexMessage> equivalence_messages(const std::size_t random_count, const uint64_t seed,
+                                                       std::vector<std::vector<uint8_t>> &storage) {
+    storage.clear();
+    for (std::size_t len = 0; len <= 33; len++) {
+        storage.emplace_back(len, 0x00);
+        storage.emplace_back(len, 0xFF);
+        std::vector<uint8_t> counting(len);
+        for (std::size_t i = 0; i < len; i++) {
+            counting[i] = static_cast<uint8_t>(i);
+        }
+        storage.push_back(counting);
+    }
+
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = 0; i < random_count; i++) {
+        std::vector<uint8_t> message(rng() % 257);
+        for (uint8_t &byte : message) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        storage.push_back(std::move(message));
+    }
+
+    std::vector<HortexMessage> messages;
+    for (const std::vector<uint8_t> &message : storage) {
+        messages.push_back({message.data(), message.size()});
+    }
+    return messages;
+}
+
+// The message as a bit string, most significant bit of every byte first, with the 10* padding: a single 1 followed by
+// at least one 0 up to a multiple of the rate, only if the message is not already a multiple of it. Built bit by bit
+// and independent of the block packing of the candidates.
+inline std::vector<bool> reference_padded_bits(const HortexMessage &message) {
+    constexpr std::size_t rate = 64;
+    std::vector<bool> bits;
+    for (std::size_t i = 0; i < message.len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            bits.push_back((message.data[i] >> b & 1) != 0);
+        }
+    }
+    if (bits.size() % rate != 0) {
+        bits.push_back(true);
+        bits.push_back(false);
+        while (bits.size() % rate != 0) {
+            bits.push_back(false);
+        }
+    }
+    return bits;
+}
+
+// The sponge of hortex as specified: 10* padding, one fFunction call per block, two squeezes. E evaluates ELM.
+template<typename I, typename E>
+void reference_hortex(const HortexMessage &message, uint8_t *digest, const E &elm) {
+    const std::vector<bool> bits = reference_padded_bits(message);
+    State state{};
+    for (std::size_t first = 0; first < bits.size(); first += 64) {
+        uint64_t block = 0;
+        for (std::size_t i = first; i < first + 64; i++) {
+            block = block << 1 | static_cast<uint64_t>(bits[i]);
+        }
+        absorb_block(state, block);
+        state = fFunction<I>(state, elm);
+    }
+    for (int j = 0; j < 2; j++) {
+        state = fFunction<I>(state, elm);
+        const uint64_t block = rate_of(state);
+        for (int i = 0; i < 8; i++) {
+            digest[8 * j + i] = static_cast<uint8_t>(block >> (56 - 8 * i));
+        }
+    }
+}
+
+// Reference ELM that records its inputs
+template<typename I>
+struct RecordingELM {
+    std::vector<uint32_t> *inputs;
+
+    uint32_t operator()(const uint32_t x) const {
+        inputs->push_back(x);
+        return ELM<I>(x);
+    }
+};
+
+// Evaluates check(begin, end) for consecutive blocks of items on thread_count threads and returns the first
+// difference per candidate. check adds differences to its thread's list.
+template<typename F>
+std::vector<EquivalenceDifference> verify_blocks(const std::size_t candidate_count, const unsigned thread_count,
+                                                 const std::size_t item_count, F &&check) {
+    std::vector<std::vector<EquivalenceDifference>> differences(thread_count, std::vector<EquivalenceDifference>(candidate_count));
+    parallel_ranges(thread_count, item_count, [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        constexpr uint64_t block = 256;
+        for (uint64_t first = begin; first < end; first += block) {
+            check(differences[t], first, std::min(end, first + block));
+        }
+    });
+
+    std::vector<EquivalenceDifference> first(candidate_count);
+    for (const std::vector<EquivalenceDifference> &thread_differences : differences) {
+        for (std::size_t c = 0; c < candidate_count; c++) {
+            if (thread_differences[c].found) {
+                first[c].add(thread_differences[c].index);
+            }
+        }
+    }
+    return first;
+}
+
+template<typename I>
+std::vector<EquivalenceDifference> verify_ffunction(const std::vector<StateCandidate<I>> &candidates,
+                                                    const std::vector<State> &states, const unsigned thread_count) {
+    return verify_blocks(candidates.size(), thread_count, states.size(),
+                         [&](std::vector<EquivalenceDifference> &differences, const uint64_t begin, const uint64_t end) {
+        std::vector<State> references(states.begin() + begin, states.begin() + end);
+        for (State &state : references) {
+            state = fFunction<I>(state);
+        }
+        for (std::size_t c = 0; c < candidates.size(); c++) {
+            std::vector<State> outputs(states.begin() + begin, states.begin() + end);
+            candidates[c].apply(outputs.data(), outputs.size());
+            for (std::size_t i = 0; i < outputs.size(); i++) {
+                if (outputs[i] != references[i]) {
+                    differences[c].add(begin + i);
+                    break;
+                }
+            }
+        }
+    });
+}
+
+template<typename I>
+std::vector<EquivalenceDifference> verify_hortex(const std::vector<MessageCandidate<I>> &candidates,
+                                                 const std::vector<HortexMessage> &messages, const unsigned thread_count) {
+    constexpr std::size_t digest_size = Hortex<I>::digest_size;
+    return verify_blocks(candidates.size(), thread_count, messages.size(),
+                         [&](std::vector<EquivalenceDifference> &differences, const uint64_t begin, const uint64_t end) {
+        std::vector<uint8_t> references(digest_size * (end - begin)), digests(digest_size * (end - begin));
+        for (uint64_t i = begin; i < end; i++) {
+            reference_hortex<I>(messages[i], references.data() + digest_size * (i - begin), ComputedELM<I>{});
+        }
+        for (std::size_t c = 0; c < candidates.size(); c++) {
+            candidates[c].hash(messages.data() + begin, end - begin, digests.data());
+            for (uint64_t i = begin; i < end; i++) {
+                if (std::memcmp(digests.data() + digest_size * (i - begin), references.data() + digest_size * (i - begin), digest_size) != 0) {
+                    differences[c].add(i);
+                    break;
+                }
+            }
+        }
+    });
+}
+
+// Reference ELM inputs of one fFunction call or of one message, in the order they are evaluated
+template<typename I>
+std::vector<uint32_t> ffunction_elm_inputs(const State &state) {
+    std::vector<uint32_t> inputs;
+    fFunction<I>(state, RecordingELM<I>{&inputs});
+    return inputs;
+}
+
+template<typename I>
+std::vector<uint32_t> hortex_elm_inputs(const HortexMessage &message) {
+    std::vector<uint32_t> inputs;
+    uint8_t digest[Hortex<I>::digest_size];
+    reference_hortex<I>(message, digest, RecordingELM<I>{&inputs});
+    return inputs;
+}
+
+// Position of the first input that elm evaluates differently from ELM<I>, or inputs.size()
+template<typename I>
+std::size_t first_elm_difference(const std::vector<uint32_t> &inputs, const std::function<uint32_t(uint32_t)> &elm) {
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+        if (elm(inputs[i]) != ELM<I>(inputs[i])) {
+            return i;
+        }
+    }
+    return inputs.size();
+}
+
+#endif
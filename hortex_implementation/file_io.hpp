@@ -0,0 +1,51 @@
+#ifndef FILE_IO_HPP
+#define FILE_IO_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+// Helpers shared by the on-disk formats: the ELM table (elm_table.hpp), the preimage index (preimage_index.hpp) and
+// the sweep checkpoints (checkpoint.hpp).
+
+// Finalizer of splitmix64, used for the checksums of the file headers and the random samples of avalanche.hpp
+inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// Writes count bytes at position, throws on failure
+inline void write_at(const int fd, const void *data, std::size_t count, uint64_t position) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (count > 0) {
+        const ssize_t written = pwrite(fd, bytes, count, static_cast<off_t>(position));
+        if (written <= 0) {
+            throw std::runtime_error(std::string("Writing failed: ") + std::strerror(errno));
+        }
+        bytes += written;
+        count -= written;
+        position += written;
+    }
+}
+
+// Reads count bytes at position, throws on failure
+inline void read_at(const int fd, void *data, std::size_t count, uint64_t position) {
+    auto *bytes = static_cast<uint8_t *>(data);
+    while (count > 0) {
+        const ssize_t read_count = pread(fd, bytes, count, static_cast<off_t>(position));
+        if (read_count <= 0) {
+            throw std::runtime_error(std::string("Reading failed: ") + std::strerror(errno));
+        }
+        bytes += read_count;
+        count -= read_count;
+        position += read_count;
+    }
+}
+
+#endif
@@ -4,117 +4,127 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <random>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-double fLM(const double eta, const double gamma) {
-    return eta * gamma * (1.0 - gamma);
-}
+#include "arguments.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
 
-double fELM(const double eta, const double gamma, const double k) {
-    const double fLM_result = fLM(eta, gamma);
-    return std::exp2(k - fLM_result);
-}
 
-double improved_fELM(const double eta, const double gamma, const double k) {
-    const double fLM_result = fLM(eta, gamma);
-    const double value = std::exp2(k - fLM_result);
-    double int_part;
-    const double fractional_part = std::modf(value, &int_part);
-    return fractional_part;
+std::string hex32(uint32_t v) {
+    std::ostringstream ss;
+    ss << "0x" << std::hex << std::uppercase << v << std::dec;
+    return ss.str();
 }
 
-uint32_t binary32(const double d) {
-    const float f = static_cast<float>(d);
-    return std::bit_cast<uint32_t>(f);
+// Pre- and post-combine collisions of one ELM variant over all 2^32 inputs, see classify_collisions
+template<typename I>
+void print_classification(const unsigned thread_count, const uint64_t memory_bytes, const uint32_t *table,
+                          ProgressReporter *progress) {
+    const CollisionClassification result = classify_collisions<I>(thread_count, memory_bytes, table, progress);
+
+    uint64_t pre_combine = 0, post_combine = 0;
+    for (int n = 0; n < ELM_N_COUNT; n++) {
+        pre_combine += result.pre_combine[n];
+        post_combine += result.post_combine[n];
+    }
+
+    std::cout << "=== Interpretation " << interpretation_name(I::id, false) << " ===\n";
+    std::cout << result.collisions << " collisions on " << result.colliding_outputs << " outputs, classified in "
+              << result.passes << (result.passes == 1 ? " pass" : " passes") << "\n";
+    std::cout << "  pre-combine (w1 and w2 identical):    " << pre_combine << "\n";
+    std::cout << "  post-combine (only rotl(w1,17) ^ w2): " << post_combine << "\n";
+    std::cout << "  n  pre-combine  post-combine\n";
+    for (int n = 0; n < ELM_N_COUNT; n++) {
+        std::cout << "  " << n << std::setw(13) << result.pre_combine[n] << std::setw(14) << result.post_combine[n] << "\n";
+    }
+    if (pre_combine + post_combine != result.collisions) {
+        std::cout << "  The classified collisions do not add up to the collisions of the first phase.\n";
+    }
+    std::cout << std::endl;
 }
 
-struct Info {
-    uint32_t x;
-    uint16_t x_left;
-    uint16_t x_middle;
-    uint16_t x_right;
-    double gamma;
-    double eta;
-    double k;
-    int n;
-    uint32_t w1;
-    uint32_t w2;
-    uint32_t result;
-};
-
-Info ELM_instrumented(const uint32_t x, const bool use_improved_elm, const int constants_setting, const bool multiplier_is_outside) {
-    Info info;
-    info.x = x;
-    info.x_left = static_cast<uint16_t>(x >> 20);
-    info.x_middle = static_cast<uint16_t>((x >> 4) & 0xFFFF);
-    info.x_right = static_cast<uint16_t>(x & 0xF);
-
-    double gamma = 0.0, eta = 0.0, k = 0.0;
-
-    if (constants_setting == 0) {
-        // Half closed interval [0,1)
-        gamma = info.x_left * (1.0 / 4096);
-        eta   = info.x_middle * (2.0 / 65536) + 2.0;
-        k     = info.x_right * (1.0 / 16) + 10.01;
-    } else if (constants_setting == 1) {
-        // (0,1]
-        gamma = (info.x_left + 1.0) * (1.0 / 4096);
-        eta   = (info.x_middle + 1.0) * (2.0 / 65536) + 2.0;
-        k     = (info.x_right + 1.0) * (1.0 / 16) + 10.01;
-    } else if (constants_setting == 2) {
-        // (0,1)
-        gamma = (info.x_left + 1.0) * (1.0 / 4097);
-        eta   = (info.x_middle + 1.0) * (2.0 / 65537) + 2.0;
-        k     = (info.x_right + 1.0) * (1.0 / 17) + 10.01;
-    } else { // 3
-        // [0,1]
-        gamma = info.x_left * (1.0 / 4095);
-        eta   = info.x_middle * (2.0 / 65535) + 2.0;
-        k     = info.x_right * (1.0 / 15) + 10.01;
+// Without arguments: samples random inputs per ELM variant and explains the first collision.
+// With exhaustive: classifies every collision of the given or of all ELM variants.
+//
+// ./find_non_bijectivity_source [exhaustive <interpretation|all> <threads> <memory_mib> <table_file>] [--progress <seconds>] [--progress-json <file>]
+int main(int argc, char *argv[]) {
+    ProgressOptions progress_options;
+    if (!take_progress_options(argc, argv, progress_options) || (argc > 1 && std::string(argv[1]) != "exhaustive")) {
+        std::cerr << "Please provide exhaustive or no argument, and only --progress <seconds> (starting from 1) and --progress-json <file>." << std::endl;
+        return 0;
+    }
+    const bool exhaustive = argc > 1;
+
+    std::unique_ptr<ProgressReporter> progress;
+    if (progress_options.enabled()) {
+        try {
+            progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 0;
+        }
     }
 
-    info.gamma = gamma; info.eta = eta; info.k = k;
-
-    const int n = static_cast<int>(std::floor(6.0 * gamma));
-    info.n = n;
-
-    uint32_t w1 = 0, w2 = 0;
-    for (int i = 0; i <= n + 1; ++i) {
-        if (use_improved_elm) gamma = improved_fELM(eta, gamma, k);
-        else                 gamma = fELM(eta, gamma, k);
-
-        if (i == n) {
-            if (multiplier_is_outside) {
-                uint32_t gamma_bits = binary32(gamma);
-                float val = std::bit_cast<float>(gamma_bits);
-                float result = val * 1e10f;
-                w1 = std::bit_cast<uint32_t>(result);
-            } else {
-                const double product = gamma * 1e10;
-                w1 = binary32(product);
+    if (exhaustive) {
+        std::vector<int> interpretations;
+        unsigned long long thread_count = default_thread_count();
+        unsigned long long memory_mib = 2048;
+
+        if (argc < 3 || std::string(argv[2]) == "all") {
+            for (int variant = 0; variant < ELM_VARIANT_COUNT; variant++) {
+                interpretations.push_back(elm_variant_interpretation(variant));
             }
-        } else if (i == n + 1) {
-            w2 = binary32(gamma);
+        } else {
+            int interpretation;
+            if (!parse_interpretation(argv[2], interpretation)) {
+                std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or all, for the second argument." << std::endl;
+                return 0;
+            }
+            interpretations.push_back(interpretation);
         }
-    }
 
-    uint32_t out = std::rotl(w1, 17) ^ w2;
+        if (argc >= 4 && !parse_number(argv[3], 1, 4096, thread_count)) {
+            std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+            return 0;
+        }
 
-    info.w1 = w1; info.w2 = w2; info.result = out;
-    return info;
-}
+        if (argc >= 5 && !parse_number(argv[4], 64, 1ull << 30, memory_mib)) {
+            std::cerr << "Please provide a number starting from 64, for the fourth argument." << std::endl;
+            return 0;
+        }
 
-std::string hex32(uint32_t v) {
-    std::ostringstream ss;
-    ss << "0x" << std::hex << std::uppercase << v << std::dec;
-    return ss.str();
-}
+        std::unique_ptr<ELMTable> table;
+        if (argc >= 6) {
+            try {
+                table = std::make_unique<ELMTable>(argv[5], ELMTableAccess::Sequential);
+                if (interpretations.size() != 1 || (table->interpretation() | 1) != (interpretations[0] | 1)) {
+                    throw std::runtime_error("The ELM table was generated for another interpretation");
+                }
+            } catch (const std::exception &e) {
+                std::cerr << e.what() << std::endl;
+                std::cerr << "Please provide an ELM table of the interpretation written by generate_elm_table, for the fifth argument." << std::endl;
+                return 0;
+            }
+        }
+
+        for (const int interpretation : interpretations) {
+            with_elm_interpretation(interpretation, [&]<typename I>(I) {
+                print_classification<I>(static_cast<unsigned>(thread_count), memory_mib << 20,
+                                        table ? table->evaluator<I>().outputs : nullptr, progress.get());
+            });
+        }
+        return 0;
+    }
 
-int main() {
     std::mt19937_64 rng(123456789ULL);
     std::uniform_int_distribution<uint32_t> dist32(0, std::numeric_limits<uint32_t>::max());
 
@@ -123,20 +133,29 @@ int main() {
     for (int use_improved = 0; use_improved <= 1; ++use_improved) {
         for (int constants_setting = 0; constants_setting < 4; ++constants_setting) {
             for (int mult_out = 0; mult_out <= 1; ++mult_out) {
-                std::unordered_map<uint32_t, Info> seen;
+                ELMInfo (*elm_instrumented)(uint32_t) = nullptr;
+                with_elm_interpretation(interpretation_id(use_improved != 0, constants_setting, mult_out != 0, true),
+                                        [&]<typename I>(I) { elm_instrumented = &ELM_instrumented<I>; });
+
+                std::unordered_map<uint32_t, ELMInfo> seen;
                 seen.reserve(100000);
                 bool found = false;
 
+                ProgressRun run(progress.get(), {"Config " + std::to_string(use_improved) + "," + std::to_string(constants_setting) +
+                                                 "," + std::to_string(mult_out), 1, MAX_TRIES_PER_CONFIG, 0, 0, 0});
+
                 for (int iter = 0; iter < MAX_TRIES_PER_CONFIG; ++iter) {
                     uint32_t x = dist32(rng);
-                    Info info = ELM_instrumented(x, use_improved != 0, constants_setting, mult_out != 0);
+                    const ELMInfo info = elm_instrumented(x);
+                    run.add(0, 1, 1, 0);
 
                     auto it = seen.find(info.result);
                     if (it == seen.end()) {
                         seen.emplace(info.result, info);
                     } else {
-                        const Info &prev = it->second;
+                        const ELMInfo &prev = it->second;
                         if (prev.x != info.x) {
+                            run.add(0, 0, 0, 1);
                             std::cout << "=== COLLISION FOUND ===\n";
                             std::cout << "Config: use_improved_elm=" << use_improved
                                       << " constants_setting=" << constants_setting
@@ -144,7 +163,7 @@ int main() {
 
                             std::cout << "Result: " << hex32(info.result) << " (" << info.result << ")\n\n";
 
-                            auto print_info = [&](const Info &I, const char *label) {
+                            auto print_info = [&](const ELMInfo &I, const char *label) {
                                 std::cout << label << " x=" << hex32(I.x) << " (dec " << I.x << ")\n";
                                 std::cout << "  x_left=" << I.x_left << " x_middle=" << I.x_middle << " x_right=" << I.x_right << "\n";
                                 std::cout << std::setprecision(12) << std::fixed;
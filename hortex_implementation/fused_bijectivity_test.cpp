@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "arguments.hpp"
+#include "checkpoint.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "slice.hpp"
+#include "sweep.hpp"
+
+// Bijectivity test of several ELM interpretations in one pass over the 2^32 inputs. Every selected interpretation
+// needs its own bitmap of 512 MiB, so the memory is chosen by the number of interpretations given. A slice of the
+// inputs is tested for one interpretation after the other with the collision structures of slice.hpp instead.
+//
+// ./fused_bijectivity_test <counting> <threads> <interpretation> [<interpretation> ...]
+//     [--checkpoint <file>] [--checkpoint-interval <seconds>] [--resume] [--progress <seconds>] [--progress-json <file>]
+//     [--x-left <filter>] [--x-middle <filter>] [--x-right <filter>]
+int main(int argc, char *argv[]) {
+	CheckpointOptions checkpoint_options;
+	if (!take_checkpoint_options(argc, argv, checkpoint_options)) {
+		std::cerr << "Please provide --checkpoint <file>, --checkpoint-interval <seconds> (starting from 1) and --resume only together with --checkpoint." << std::endl;
+		return 0;
+	}
+
+	ProgressOptions progress_options;
+	if (!take_progress_options(argc, argv, progress_options)) {
+		std::cerr << "Please provide --progress <seconds> (starting from 1) and --progress-json <file>." << std::endl;
+		return 0;
+	}
+
+	InputSlice slice;
+	if (!take_slice_options(argc, argv, slice)) {
+		std::cerr << "Please provide --x-left, --x-middle and --x-right as v, lo-hi, value/mask or lo-hi,value/mask, matching at least one input." << std::endl;
+		return 0;
+	}
+
+	bool counting_activated = false;
+	unsigned long long thread_count = default_thread_count();
+	uint32_t variant_mask = 0;
+
+	if (argc >= 2 && !parse_bool(argv[1], counting_activated)) {
+		std::cerr << "Please provide either the value true or false, for the first argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 3 && !parse_number(argv[2], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the second argument." << std::endl;
+		return 0;
+	}
+
+	for (int i = 3; i < argc; i++) {
+		int interpretation;
+		if (std::string(argv[i]) == "all") {
+			variant_mask = (uint32_t{1} << ELM_VARIANT_COUNT) - 1;
+		} else if (parse_interpretation(argv[i], interpretation)) {
+			variant_mask |= uint32_t{1} << elm_variant(interpretation);
+		} else {
+			std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or all, for the argument " << i << "." << std::endl;
+			return 0;
+		}
+	}
+
+	if (variant_mask == 0) {
+		variant_mask = (uint32_t{1} << ELM_VARIANT_COUNT) - 1;
+	}
+
+	if (!slice.full()) {
+		if (!checkpoint_options.path.empty()) {
+			std::cerr << "Please provide no checkpoint when testing a slice." << std::endl;
+			return 0;
+		}
+		std::cout << "Testing " << std::popcount(variant_mask) << " interpretations on a slice of " << slice.size() << " inputs." << std::endl;
+	} else {
+		std::cout << "Testing " << std::popcount(variant_mask) << " interpretations with " << std::popcount(variant_mask) * 512
+				  << " MiB of bitmaps." << std::endl;
+	}
+
+	std::unique_ptr<ProgressReporter> progress;
+	if (progress_options.enabled()) {
+		try {
+			progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
+
+	std::vector<BijectivityResult> results;
+	if (!slice.full()) {
+		results.resize(ELM_VARIANT_COUNT);
+		for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+			if ((variant_mask >> v & 1) != 0) {
+				with_elm_interpretation(elm_variant_interpretation(v), [&]<typename I>(I) {
+					results[v] = slice_bijectivity<I>(slice, counting_activated, static_cast<unsigned>(thread_count)).result;
+				});
+			}
+		}
+	} else if (checkpoint_options.path.empty()) {
+		results = fused_bijectivity_sweep(variant_mask, counting_activated, thread_count, nullptr, progress.get());
+	} else {
+		try {
+			SweepCheckpoint checkpoint(checkpoint_options.path, static_cast<double>(checkpoint_options.interval_seconds),
+									   variant_mask, counting_activated, checkpoint_options.resume);
+			const BijectivityCheckpoint hooks = checkpoint.hooks();
+			results = fused_bijectivity_sweep(variant_mask, counting_activated, thread_count, &hooks, progress.get());
+			checkpoint.remove();
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
+
+	for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+		if ((variant_mask >> v & 1) == 0) {
+			continue;
+		}
+
+		const BijectivityResult &result = results[v];
+		std::cout << "Output with settings:" << interpretation_name(elm_variant_interpretation(v), false) << ": ";
+		if (counting_activated) {
+			std::cout << result.collisions << " collision pairs found." << std::endl;
+		} else if (result.collision_found) {
+			std::cout << "Input " << result.collision_input << " collides with another input that produces the output " << result.collision_output << "." << std::endl;
+		} else {
+			std::cout << "No collision found." << std::endl;
+		}
+	}
+	return 0;
+}
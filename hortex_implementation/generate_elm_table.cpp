@@ -0,0 +1,59 @@
+#include <exception>
+#include <iostream>
+
+#include "arguments.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Writes the table of all 2^32 outputs of an ELM interpretation (16 GiB), or checks an existing table.
+//
+// ./generate_elm_table <interpretation> <table_file> <threads>
+// ./generate_elm_table verify <table_file> <threads>
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or verify, and the table file." << std::endl;
+		return 0;
+	}
+
+	unsigned long long thread_count = default_thread_count();
+
+	if (argc >= 4 && !parse_number(argv[3], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	if (std::string(argv[1]) == "verify") {
+		try {
+			const ELMTable table(argv[2], ELMTableAccess::Sequential);
+			std::cout << "Interpretation: " << interpretation_name(table.interpretation(), false) << std::endl;
+			with_elm_interpretation(table.interpretation(), [&]<typename I>(I) { table.evaluator<I>(); });
+
+			if (table.verify_checksum(thread_count)) {
+				std::cout << "The checksum of " << argv[2] << " is correct." << std::endl;
+			} else {
+				std::cout << "The checksum of " << argv[2] << " is wrong." << std::endl;
+			}
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+		}
+		return 0;
+	}
+
+	int interpretation = DefaultInterpretation::id;
+
+	if (!parse_interpretation(argv[1], interpretation)) {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or verify, for the first argument." << std::endl;
+		return 0;
+	}
+
+	try {
+		with_elm_interpretation(interpretation, [&]<typename I>(I) { generate_elm_table<I>(argv[2], thread_count); });
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 0;
+	}
+
+	std::cout << "ELM table of the interpretation " << interpretation_name(interpretation, false) << " written to " << argv[2] << "." << std::endl;
+	return 0;
+}
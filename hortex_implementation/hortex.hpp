@@ -0,0 +1,518 @@
+#ifndef HORTEX_HPP
+#define HORTEX_HPP
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "instrumentation.hpp"
+
+// Interpretation of the ambiguous parts of the hortex specification. Every combination is a distinct type, so each
+// of the 32 variants of ELM, fFunction and hortex is compiled into its own kernel without any runtime configuration
+// checks.
+//
+// use_improved_elm:      fELM as defined by M. Alawida (with modf) instead of the one defined by Masri & Susanti
+// constants_setting:     0 = [0,1), 1 = (0,1], 2 = (0,1), 3 = [0,1] as interval for the starting values
+// multiplier_is_outside: w1 = binary32(gamma) * 1e10f instead of binary32(gamma * 1e10)
+// use_pseudocode_arx:    ARX layer of the pseudo code instead of the one of the diagram
+template<bool UseImprovedElm, int ConstantsSetting, bool MultiplierIsOutside, bool UsePseudocodeArx>
+struct Interpretation {
+    static_assert(ConstantsSetting >= 0 && ConstantsSetting < 4, "constants_setting must be 0, 1, 2 or 3");
+
+    static constexpr bool use_improved_elm = UseImprovedElm;
+    static constexpr int constants_setting = ConstantsSetting;
+    static constexpr bool multiplier_is_outside = MultiplierIsOutside;
+    static constexpr bool use_pseudocode_arx = UsePseudocodeArx;
+
+    static constexpr int id = (UseImprovedElm ? 16 : 0) | ConstantsSetting << 2 | (MultiplierIsOutside ? 2 : 0) |
+                              (UsePseudocodeArx ? 1 : 0);
+};
+
+// Interpretation used by hortex.cpp, bijectivity_test.cpp and search_elm_collisions.cpp
+using DefaultInterpretation = Interpretation<true, 3, false, true>;
+
+constexpr int interpretation_count = 32;
+
+constexpr int interpretation_id(const bool use_improved_elm, const int constants_setting, const bool multiplier_is_outside,
+                                const bool use_pseudocode_arx) {
+    return (use_improved_elm ? 16 : 0) | constants_setting << 2 | (multiplier_is_outside ? 2 : 0) | (use_pseudocode_arx ? 1 : 0);
+}
+
+template<int Id>
+using InterpretationById = Interpretation<(Id & 16) != 0, (Id >> 2) & 3, (Id & 2) != 0, (Id & 1) != 0>;
+
+// Calls f with a default constructed Interpretation matching the runtime id. Tools that loop over several
+// interpretations use this to enter the compile-time variant once, outside of their hot loops.
+template<typename F>
+void with_interpretation(const int id, F &&f) {
+    [&]<int... Ids>(std::integer_sequence<int, Ids...>) {
+        ((id == Ids ? (f(InterpretationById<Ids>{}), 0) : 0), ...);
+    }(std::make_integer_sequence<int, interpretation_count>{});
+}
+
+// Like with_interpretation for code that only depends on ELM, which ignores use_pseudocode_arx. Only the 16 ELM
+// variants are instantiated, f always gets the interpretation with the ARX layer of the pseudo code.
+template<typename F>
+void with_elm_interpretation(const int id, F &&f) {
+    [&]<int... Ids>(std::integer_sequence<int, Ids...>) {
+        (((id | 1) == 2 * Ids + 1 ? (f(InterpretationById<2 * Ids + 1>{}), 0) : 0), ...);
+    }(std::make_integer_sequence<int, interpretation_count / 2>{});
+}
+
+// ELM is specified with one rounding per operation. GCC contracts a * b + c into an FMA by default whenever the target
+// has FMA (-mfma, -march=native), which changes the outputs, so the reference is compiled without contraction like the
+// batch kernels in elm_batch.hpp.
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+
+// Logistic Map Function
+inline double fLM(const double eta, const double gamma) {
+    return eta * gamma * (1.0 - gamma);
+}
+
+// Exponent of fELM, a product followed by a subtraction that an FMA would round only once
+inline double fELM_exponent(const double eta, const double gamma, const double k) {
+    return k - fLM(eta, gamma);
+}
+
+// Enhanced Logistic Map Function as defined by Masri & Susanti, or the Enhanced Chaotic Logistic Map Function as
+// defined by M. Alawida if the interpretation uses the improved ELM
+template<typename I>
+inline double fELM(const double eta, const double gamma, const double k) {
+    const double value = HORTEX_MEASURE(Exp2, std::exp2(fELM_exponent(eta, gamma, k)));
+
+    if constexpr (I::use_improved_elm) {
+        double int_part;
+        return HORTEX_MEASURE(Modf, std::modf(value, &int_part));
+    } else {
+        return value;
+    }
+}
+
+// Conversion of a real number to the binary representation of the IEEE 754 single precision format
+inline uint32_t binary32(const double d) {
+    const auto f = HORTEX_MEASURE(Binary32, static_cast<float>(d));
+    return std::bit_cast<uint32_t>(f);
+}
+
+// Starting values of the ELM algorithm derived from the three input fields
+struct ELMParameters {
+    double gamma;
+    double eta;
+    double k;
+    int n;
+};
+
+template<typename I>
+inline ELMParameters ELM_parameters(const uint32_t x) {
+    const uint16_t x_left = x >> 20;
+    const uint16_t x_middle = x >> 4 & 0xFFFF;
+    const uint16_t x_right = x & 0xF;
+
+    ELMParameters p;
+
+    if constexpr (I::constants_setting == 0) {
+        // Half closed interval [0,1)
+        p.gamma = x_left * (1.0 / 4096);
+        p.eta = x_middle * (2.0 / 65536) + 2.0;
+        p.k = x_right * (1.0 / 16) + 10.01;
+    } else if constexpr (I::constants_setting == 1) {
+        // Half closed interval (0,1]
+        p.gamma = (x_left + 1.0) * (1.0 / 4096);
+        p.eta = (x_middle + 1.0) * (2.0 / 65536) + 2.0;
+        p.k = (x_right + 1.0) * (1.0 / 16) + 10.01;
+    } else if constexpr (I::constants_setting == 2) {
+        // Open interval (0,1)
+        p.gamma = (x_left + 1.0) * (1.0 / 4097);
+        p.eta = (x_middle + 1.0) * (2.0 / 65537) + 2.0;
+        p.k = (x_right + 1.0) * (1.0 / 17) + 10.01;
+    } else {
+        // Closed interval [0,1]
+        p.gamma = x_left * (1.0 / 4095);
+        p.eta = x_middle * (2.0 / 65535) + 2.0;
+        p.k = x_right * (1.0 / 15) + 10.01;
+    }
+
+    p.n = static_cast<int>(std::floor(6.0 * p.gamma));
+
+    return p;
+}
+
+template<typename I>
+inline uint32_t ELM_w1(const double gamma) {
+    if constexpr (I::multiplier_is_outside) {
+        const float val = std::bit_cast<float>(binary32(gamma));
+        return std::bit_cast<uint32_t>(val * 1e10f);
+    } else {
+        return binary32(gamma * 1e10);
+    }
+}
+
+// ELM Algorithm: n + 2 iterations of fELM, w1 is taken after iteration n + 1 and w2 after iteration n + 2
+template<typename I>
+inline uint32_t ELM(const uint32_t x) {
+    const ELMParameters p = ELM_parameters<I>(x);
+    double gamma = p.gamma;
+    HORTEX_COUNT_N(p.n);
+
+    for (int i = 0; i < p.n; i++) {
+        gamma = fELM<I>(p.eta, gamma, p.k);
+    }
+
+    gamma = fELM<I>(p.eta, gamma, p.k);
+    const uint32_t w1 = ELM_w1<I>(gamma);
+
+    gamma = fELM<I>(p.eta, gamma, p.k);
+    const uint32_t w2 = binary32(gamma);
+
+    return std::rotl(w1, 17) ^ w2;
+}
+
+// All intermediate values of one ELM evaluation, used to explain collisions
+struct ELMInfo {
+    uint32_t x;
+    uint16_t x_left;
+    uint16_t x_middle;
+    uint16_t x_right;
+    double gamma;
+    double eta;
+    double k;
+    int n;
+    uint32_t w1;
+    uint32_t w2;
+    uint32_t result;
+};
+
+template<typename I>
+inline ELMInfo ELM_instrumented(const uint32_t x) {
+    const ELMParameters p = ELM_parameters<I>(x);
+
+    ELMInfo info;
+    info.x = x;
+    info.x_left = static_cast<uint16_t>(x >> 20);
+    info.x_middle = static_cast<uint16_t>(x >> 4 & 0xFFFF);
+    info.x_right = static_cast<uint16_t>(x & 0xF);
+    info.gamma = p.gamma;
+    info.eta = p.eta;
+    info.k = p.k;
+    info.n = p.n;
+
+    double gamma = p.gamma;
+
+    for (int i = 0; i < p.n; i++) {
+        gamma = fELM<I>(p.eta, gamma, p.k);
+    }
+
+    gamma = fELM<I>(p.eta, gamma, p.k);
+    info.w1 = ELM_w1<I>(gamma);
+
+    gamma = fELM<I>(p.eta, gamma, p.k);
+    info.w2 = binary32(gamma);
+
+    info.result = std::rotl(info.w1, 17) ^ info.w2;
+
+    return info;
+}
+
+#pragma GCC pop_options
+
+// ARX layer applied to the eight ELM outputs
+template<typename I>
+inline void ARX(uint32_t &v1, uint32_t &v2, uint32_t &v3, uint32_t &v4, uint32_t &v5, uint32_t &v6, uint32_t &v7, uint32_t &v8) {
+    if constexpr (I::use_pseudocode_arx) {
+        // Pseudo Code Implementation
+        v1 = std::rotl(v1, 19) + std::rotl(v3, 9);
+        v5 = std::rotl(v5 ^ std::rotl(v3, 9), 7);
+        v6 = std::rotl(v6 ^ std::rotl(v4, 17), 13);
+        v7 = v7 + v5;
+        v8 = std::rotl(v8, 11) ^ v6;
+        v2 = v2 + v6;
+        v3 = std::rotl(v3, 9) ^ v7;
+        v4 = std::rotl(v4, 17) + v2;
+    } else {
+        // Diagram Implementation
+        v1 = std::rotl(v1, 19) + std::rotl(v3, 9);
+        v5 = std::rotl(v5 ^ std::rotl(v3, 9), 7);
+        v6 = std::rotl(v6 + std::rotl(v4, 17), 13);
+        v7 = v7 ^ v5;
+        v8 = std::rotl(v8, 11) ^ v6;
+        v2 = v2 + v6;
+        v3 = std::rotl(v3, 9) ^ v7;
+        v4 = std::rotl(v4, 17) + v2;
+    }
+}
+
+// Sponge state as eight 32-bit words. words[0] holds the 32 most significant bits of the 256-bit string, so the
+// rate (the upper 64 bits) is words[0] and words[1]. Conversions to std::bitset only happen at the API boundary.
+using State = std::array<uint32_t, 8>;
+
+inline State to_state(const std::bitset<256> &x) {
+    constexpr std::bitset<256> mask(0xFFFFFFFF);
+    HORTEX_STAGE_BEGIN(Packing);
+
+    State s;
+    for (int i = 0; i < 8; i++) {
+        s[i] = static_cast<uint32_t>((x >> (256 - (i + 1) * 32) & mask).to_ulong());
+    }
+    HORTEX_STAGE_END(Packing);
+    return s;
+}
+
+inline std::bitset<256> to_bitset(const State &s) {
+    HORTEX_STAGE_BEGIN(Packing);
+    std::bitset<256> x;
+    for (int i = 0; i < 8; i++) {
+        x = x << 32 | std::bitset<256>(s[i]);
+    }
+    HORTEX_STAGE_END(Packing);
+    return x;
+}
+
+// XOR of a 64-bit block into the rate
+inline void absorb_block(State &s, const uint64_t block) {
+    HORTEX_STAGE_BEGIN(Packing);
+    s[0] ^= static_cast<uint32_t>(block >> 32);
+    s[1] ^= static_cast<uint32_t>(block);
+    HORTEX_STAGE_END(Packing);
+}
+
+inline uint64_t rate_of(const State &s) {
+    return static_cast<uint64_t>(s[0]) << 32 | s[1];
+}
+
+// ELM evaluated by computation, the default of fFunction and Hortex. elm_table.hpp provides a lookup table instead.
+template<typename I>
+struct ComputedELM {
+    uint32_t operator()(const uint32_t x) const {
+        return ELM<I>(x);
+    }
+};
+
+// Transformation Function f
+template<typename I, typename E = ComputedELM<I>>
+inline State fFunction(const State &x, const E &elm = E{}) {
+    // The ELM calls form the chain v2 -> v3 -> ... -> v8 -> v1
+    HORTEX_STAGE_BEGIN(ELMChain);
+    uint32_t v2 = elm(x[0]);
+    uint32_t v3 = elm(x[1] ^ v2);
+    uint32_t v4 = elm(x[2] ^ v3);
+    uint32_t v5 = elm(x[3] ^ v4);
+    uint32_t v6 = elm(x[4] ^ v5);
+    uint32_t v7 = elm(x[5] ^ v6);
+    uint32_t v8 = elm(x[6] ^ v7);
+    uint32_t v1 = elm(x[7] ^ v8);
+    HORTEX_STAGE_END(ELMChain);
+
+    HORTEX_STAGE_BEGIN(ARX);
+    ARX<I>(v1, v2, v3, v4, v5, v6, v7, v8);
+    HORTEX_STAGE_END(ARX);
+
+    return {v1, v2, v3, v4, v5, v6, v7, v8};
+}
+
+template<typename I>
+std::bitset<256> fFunction(const std::bitset<256> &x) {
+    return to_bitset(fFunction<I>(to_state(x)));
+}
+
+// Incremental hortex over a byte stream. Bytes are read most significant bit first, so a message of the bytes
+// b0 b1 ... corresponds to the bit string b0[7] b0[6] ... b0[0] b1[7] ... of the std::bitset entry point. Only the
+// state and one partial 64-bit block are kept, independent of the message length.
+//
+// Usage: init() (or construction), any number of update() calls, then final(). A trailing bit string shorter than
+// one byte can be passed to final() as the last_bit_count most significant bits of last_bits. E evaluates ELM, see
+// ComputedELM. hortex starts from the all-zero state; other modes (hortex_tree.hpp) pass their own initial state.
+//
+// As an extendable-output function (XOF), finish() takes the place of final() and any number of squeeze() calls
+// follow. Every squeezing fFunction call yields 64 bits of the rate, and the first digest_size bytes of the stream
+// are the digest of final().
+template<typename I, typename E = ComputedELM<I>>
+class Hortex {
+public:
+    static constexpr int rate = 64;
+    static constexpr std::size_t digest_size = 16;
+
+    explicit Hortex(const E &elm = E{}) : elm(elm), initial_state{} {
+        init();
+    }
+
+    explicit Hortex(const State &initial_state, const E &elm = E{}) : elm(elm), initial_state(initial_state) {
+        init();
+    }
+
+    void init() {
+        state = initial_state;
+        buffer = 0;
+        buffered_bytes = 0;
+    }
+
+    void update(const uint8_t *data, std::size_t len) {
+        while (buffered_bytes != 0 && len > 0) {
+            push_byte(*data++);
+            len--;
+        }
+
+        while (len >= 8) {
+            absorb(load_block(data));
+            data += 8;
+            len -= 8;
+        }
+
+        while (len > 0) {
+            push_byte(*data++);
+            len--;
+        }
+    }
+
+    // Applies the 10* padding, absorbs the last block(s) and writes the 128-bit digest in big-endian byte order
+    void final(uint8_t *digest, const uint8_t last_bits = 0, const int last_bit_count = 0) {
+        finish(last_bits, last_bit_count);
+        squeeze(digest, digest_size);
+    }
+
+    // Applies the 10* padding and absorbs the last block(s) like final(), then only squeeze() may follow until init().
+    // Throws std::invalid_argument unless 0 <= last_bit_count <= 7, a whole byte belongs into update().
+    void finish(const uint8_t last_bits = 0, const int last_bit_count = 0) {
+        if (last_bit_count < 0 || last_bit_count > 7) {
+            throw std::invalid_argument("last_bit_count must be from 0 to 7");
+        }
+        const int used_bits = buffered_bytes * 8 + last_bit_count;
+
+        uint64_t block = buffered_bytes == 0 ? 0 : buffer << (rate - buffered_bytes * 8);
+        if (last_bit_count > 0) {
+            block |= static_cast<uint64_t>(last_bits >> (8 - last_bit_count)) << (rate - used_bits);
+        }
+
+        // 10* Padding: a single 1 followed by at least one 0, only if the message is not a multiple of the rate
+        if (used_bits != 0) {
+            if (used_bits < rate - 1) {
+                absorb(block | uint64_t{1} << (rate - 1 - used_bits));
+            } else {
+                absorb(block | 1);
+                absorb(0);
+            }
+        }
+
+        // From here on buffer holds the last squeezed block and buffered_bytes the number of its bytes not yet output
+        buffer = 0;
+        buffered_bytes = 0;
+    }
+
+    // Squeezing Phase: writes the next len bytes of the output stream to out. The stream does not depend on how it is
+    // split into calls.
+    void squeeze(uint8_t *out, std::size_t len) {
+        while (buffered_bytes > 0 && len > 0) {
+            *out++ = static_cast<uint8_t>(buffer >> (8 * --buffered_bytes));
+            len--;
+        }
+
+        while (len >= 8) {
+            state = fFunction<I>(state, elm);
+            store_block(out, rate_of(state));
+            out += 8;
+            len -= 8;
+        }
+
+        if (len > 0) {
+            state = fFunction<I>(state, elm);
+            buffer = rate_of(state);
+            buffered_bytes = 8 - static_cast<int>(len);
+            for (std::size_t i = 0; i < len; i++) {
+                out[i] = static_cast<uint8_t>(buffer >> (56 - 8 * i));
+            }
+        }
+    }
+
+private:
+    static uint64_t load_block(const uint8_t *p) {
+        uint64_t block;
+        std::memcpy(&block, p, sizeof(block));
+        if constexpr (std::endian::native == std::endian::little) {
+            block = std::byteswap(block);
+        }
+        return block;
+    }
+
+    static void store_block(uint8_t *p, uint64_t block) {
+        HORTEX_STAGE_BEGIN(Packing);
+        if constexpr (std::endian::native == std::endian::little) {
+            block = std::byteswap(block);
+        }
+        std::memcpy(p, &block, sizeof(block));
+        HORTEX_STAGE_END(Packing);
+    }
+
+    void push_byte(const uint8_t byte) {
+        buffer = buffer << 8 | byte;
+        if (++buffered_bytes == 8) {
+            absorb(buffer);
+            buffer = 0;
+            buffered_bytes = 0;
+        }
+    }
+
+    // Absorbing Phase
+    void absorb(const uint64_t block) {
+        absorb_block(state, block);
+        state = fFunction<I>(state, elm);
+    }
+
+    E elm;
+    State initial_state;
+    State state;
+    uint64_t buffer;
+    int buffered_bytes;
+};
+
+// One-shot hortex of a byte string
+template<typename I, typename E = ComputedELM<I>>
+void hortex(const uint8_t *data, const std::size_t len, uint8_t *digest, const E &elm = E{}) {
+    Hortex<I, E> ctx(elm);
+    ctx.update(data, len);
+    ctx.final(digest);
+}
+
+// One-shot XOF of a byte string: out_len bytes of output, the first digest_size of which are the hortex digest
+template<typename I, typename E = ComputedELM<I>>
+void hortex_xof(const uint8_t *data, const std::size_t len, uint8_t *out, const std::size_t out_len, const E &elm = E{}) {
+    Hortex<I, E> ctx(elm);
+    ctx.update(data, len);
+    ctx.finish();
+    ctx.squeeze(out, out_len);
+}
+
+inline std::bitset<128> digest_to_bitset(const uint8_t *digest) {
+    std::bitset<128> h;
+    for (std::size_t i = 0; i < 16; i++) {
+        h = h << 8 | std::bitset<128>(digest[i]);
+    }
+    return h;
+}
+
+// hortex of a bit string given as std::bitset, bit N - 1 is the first bit of the message
+template<typename I, std::size_t N>
+std::bitset<128> hortex(const std::bitset<N> &x) {
+    Hortex<I> ctx;
+    uint8_t byte = 0;
+
+    for (std::size_t i = 0; i < N; i++) {
+        byte = static_cast<uint8_t>(byte << 1 | x[N - 1 - i]);
+        if (i % 8 == 7) {
+            ctx.update(&byte, 1);
+            byte = 0;
+        }
+    }
+
+    uint8_t digest[Hortex<I>::digest_size];
+    ctx.final(digest, static_cast<uint8_t>(byte << (8 - N % 8)), N % 8);
+
+    return digest_to_bitset(digest);
+}
+
+#endif
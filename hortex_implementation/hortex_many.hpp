@@ -0,0 +1,133 @@
+#ifndef HORTEX_MANY_HPP
+#define HORTEX_MANY_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "elm_batch.hpp"
+#include "hortex.hpp"
+
+// hortex of many independent messages on one core. The eight ELM calls of fFunction form a chain, so a single
+// message waits for every ELM in turn. hortex_many keeps up to Lanes sponge states in flight and evaluates each link
+// of their chains with one ELM_batch call, so the ELM calls of different messages share the SIMD lanes and overlap in
+// the pipeline. Every state needs one fFunction call per round, absorbing or squeezing; a state whose message is
+// complete is retired and its lane takes the next message, so messages of different lengths do not wait for each
+// other. The digests equal the ones of hortex.
+
+struct HortexMessage {
+    const uint8_t *data;
+    std::size_t len;
+};
+
+constexpr int HORTEX_MANY_LANES = 16;
+
+// Block number block of the message with the 10* padding, as absorbed by Hortex: the last partial block carries a
+// single 1 after the message bytes, a message of full blocks has no padding
+inline uint64_t hortex_many_block(const HortexMessage &message, const std::size_t block) {
+    const std::size_t offset = 8 * block;
+    const std::size_t bytes = message.len - offset < 8 ? message.len - offset : 8;
+
+    uint64_t value = 0;
+    if (bytes == 8) {
+        std::memcpy(&value, message.data + offset, sizeof(value));
+        if constexpr (std::endian::native == std::endian::little) {
+            value = std::byteswap(value);
+        }
+        return value;
+    }
+    for (std::size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(message.data[offset + i]) << (56 - 8 * i);
+    }
+    return value | uint64_t{1} << (63 - 8 * bytes);
+}
+
+// states[l] = fFunction<I>(states[l]) for l < count <= Lanes. Link j of the ELM chain of all states is one ELM_batch
+// call.
+template<typename I, int Lanes = HORTEX_MANY_LANES>
+void fFunction_many(State *states, const int count, const ELMBackend backend = detected_backend()) {
+    uint32_t in[Lanes];
+    // chain[j][l]: output of link j of lane l, i.e. v2, v3, ..., v8, v1
+    uint32_t chain[8][Lanes];
+
+    for (int j = 0; j < 8; j++) {
+        for (int l = 0; l < count; l++) {
+            in[l] = j == 0 ? states[l][0] : states[l][j] ^ chain[j - 1][l];
+        }
+        ELM_batch<I>(in, chain[j], static_cast<std::size_t>(count), backend);
+    }
+
+    for (int l = 0; l < count; l++) {
+        uint32_t v1 = chain[7][l], v2 = chain[0][l], v3 = chain[1][l], v4 = chain[2][l];
+        uint32_t v5 = chain[3][l], v6 = chain[4][l], v7 = chain[5][l], v8 = chain[6][l];
+        ARX<I>(v1, v2, v3, v4, v5, v6, v7, v8);
+        states[l] = {v1, v2, v3, v4, v5, v6, v7, v8};
+    }
+}
+
+// digests + Hortex<I>::digest_size * i receives the digest of messages[i] for i < count. Every message starts from
+// the all-zero state of hortex, or from initial_states[i] if given (see hortex_tree.hpp).
+template<typename I, int Lanes = HORTEX_MANY_LANES>
+void hortex_many(const HortexMessage *messages, const std::size_t count, uint8_t *digests,
+                 const ELMBackend backend = detected_backend(), const State *initial_states = nullptr) {
+    struct Lane {
+        std::size_t message;
+        // fFunction calls done and needed: one per absorbed block and two for squeezing
+        std::size_t call;
+        std::size_t calls;
+    };
+
+    State states[Lanes];
+    Lane lanes[Lanes];
+    std::size_t next = 0;
+    int active = 0;
+
+    auto start = [&](const int l) {
+        if (next == count) {
+            return false;
+        }
+        lanes[l] = {next, 0, (messages[next].len + 7) / 8 + 2};
+        states[l] = initial_states != nullptr ? initial_states[next] : State{};
+        next++;
+        return true;
+    };
+
+    while (active < Lanes && start(active)) {
+        active++;
+    }
+
+    while (active > 0) {
+        for (int l = 0; l < active; l++) {
+            if (lanes[l].call < lanes[l].calls - 2) {
+                absorb_block(states[l], hortex_many_block(messages[lanes[l].message], lanes[l].call));
+            }
+        }
+
+        fFunction_many<I, Lanes>(states, active, backend);
+
+        for (int l = 0; l < active; l++) {
+            Lane &lane = lanes[l];
+            if (lane.call >= lane.calls - 2) {
+                uint64_t block = rate_of(states[l]);
+                if constexpr (std::endian::native == std::endian::little) {
+                    block = std::byteswap(block);
+                }
+                std::memcpy(digests + Hortex<I>::digest_size * lane.message + 8 * (lane.call - (lane.calls - 2)), &block,
+                            sizeof(block));
+            }
+            lane.call++;
+        }
+
+        // Finished lanes take the next message, or the last active lane moves into their place
+        for (int l = active - 1; l >= 0; l--) {
+            if (lanes[l].call == lanes[l].calls && !start(l)) {
+                active--;
+                states[l] = states[active];
+                lanes[l] = lanes[active];
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "hortex.hpp"
+#include "hortex_tree.hpp"
+#include "sweep.hpp"
+
+// Test vectors and throughput of the tree mode in hortex_tree.hpp for the interpretation of hortex.cpp.
+//
+// Every test vector is hashed with hortex_tree on one and on thread_count threads and with a plain sequential
+// evaluation of the tree (one Hortex context per leaf), and the digests are compared with the published ones below.
+// Then a message of the given size is hashed with 1, 2, 4, ... up to thread_count threads and the throughput is
+// printed next to the one of sequential hortex.
+//
+// ./hortex_tree <thread_count> <megabytes>
+
+struct TreeTestVector {
+	std::size_t len;
+	int chunk_log2;
+	const char *digest;
+};
+
+// Message of len bytes i mod 251, interpretation true,3,false,true
+const TreeTestVector TREE_TEST_VECTORS[] = {
+	{0, 16, "bd27bb07ff8fa30506e7c73eb23d7f13"},
+	{1, 16, "575ed76bab949b3919aac0451199d02e"},
+	{8, 16, "6e027a96e87dcef6dd8e0eace0e3423e"},
+	{1000, 16, "0887e4454d87153bf347e7229966bb1a"},
+	{65536, 16, "fb7b7f8451f429689748245396307e71"},
+	{65537, 16, "965a276cc710e0b304856d9e82de9c4a"},
+	{1000000, 16, "8dcad7c5c3aba2bfa35ed27acafbdb4c"},
+	{0, 10, "77e06d072a15d328cc642ee3a3805825"},
+	{1024, 10, "9eb2ae2b2f221d9152aaf6329bd5abf5"},
+	{1025, 10, "ee91a9133d3e6eeb966479065e87a8b0"},
+	{100000, 10, "d10db326e933623f7b1b4ed77ce85f6d"},
+};
+
+inline std::string to_hex(const uint8_t *bytes, const std::size_t len) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (std::size_t i = 0; i < len; i++) {
+		ss << std::setw(2) << static_cast<int>(bytes[i]);
+	}
+	return ss.str();
+}
+
+std::vector<uint8_t> test_message(const std::size_t len) {
+	std::vector<uint8_t> message(len);
+	for (std::size_t i = 0; i < len; i++) {
+		message[i] = static_cast<uint8_t>(i % 251);
+	}
+	return message;
+}
+
+// The tree mode as specified, one leaf after the other
+template<typename I>
+void sequential_tree(const uint8_t *data, const std::size_t len, uint8_t *digest, const int chunk_log2) {
+	const std::size_t chunk_size = std::size_t{1} << chunk_log2;
+	Hortex<I> root(hortex_tree_root_state(chunk_log2));
+	for (std::size_t chunk = 0; chunk < hortex_tree_chunk_count(len, chunk_log2); chunk++) {
+		const std::size_t offset = chunk * chunk_size;
+		uint8_t chaining_value[Hortex<I>::digest_size];
+		Hortex<I> leaf(hortex_tree_leaf_state(chunk, chunk_log2));
+		leaf.update(data + offset, std::min(chunk_size, len - offset));
+		leaf.final(chaining_value);
+		root.update(chaining_value, sizeof(chaining_value));
+	}
+	uint8_t length[8];
+	for (int i = 0; i < 8; i++) {
+		length[i] = static_cast<uint8_t>(static_cast<uint64_t>(len) >> (56 - 8 * i));
+	}
+	root.update(length, sizeof(length));
+	root.final(digest);
+}
+
+template<typename F>
+double seconds_of(F &&f) {
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+	using I = DefaultInterpretation;
+	unsigned long long thread_count = default_thread_count();
+	unsigned long long megabytes = 64;
+
+	if (argc >= 2 && !parse_number(argv[1], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the first argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 3 && !parse_number(argv[2], 1, 65536, megabytes)) {
+		std::cerr << "Please provide a number from 1 to 65536, for the second argument." << std::endl;
+		return 0;
+	}
+
+	bool all_match = true;
+	for (const TreeTestVector &vector : TREE_TEST_VECTORS) {
+		const std::vector<uint8_t> message = test_message(vector.len);
+		uint8_t expected[Hortex<I>::digest_size], single[Hortex<I>::digest_size], threaded[Hortex<I>::digest_size];
+		sequential_tree<I>(message.data(), message.size(), expected, vector.chunk_log2);
+		hortex_tree<I>(message.data(), message.size(), single, vector.chunk_log2, 1);
+		hortex_tree<I>(message.data(), message.size(), threaded, vector.chunk_log2, static_cast<unsigned>(thread_count));
+
+		const std::string digest = to_hex(expected, sizeof(expected));
+		const bool match = digest == vector.digest && to_hex(single, sizeof(single)) == digest
+						   && to_hex(threaded, sizeof(threaded)) == digest;
+		all_match = all_match && match;
+		std::cout << "len " << vector.len << ", chunk_log2 " << vector.chunk_log2 << ": " << digest
+				  << (match ? " Match" : " Mismatch") << std::endl;
+	}
+	if (!all_match) {
+		std::cout << "Test vectors were not reproduced." << std::endl;
+		return 1;
+	}
+
+	const std::vector<uint8_t> message = test_message(static_cast<std::size_t>(megabytes) << 20);
+	uint8_t digest[Hortex<I>::digest_size];
+	const double sequential = seconds_of([&] { hortex<I>(message.data(), message.size(), digest); });
+	std::cout << "hortex: " << static_cast<double>(message.size()) / sequential / 1e6 << " MB/s" << std::endl;
+
+	for (unsigned threads = 1;; threads = std::min<unsigned>(2 * threads, static_cast<unsigned>(thread_count))) {
+		const double seconds = seconds_of([&] {
+			hortex_tree<I>(message.data(), message.size(), digest, HORTEX_TREE_DEFAULT_CHUNK_LOG2, threads);
+		});
+		std::cout << "hortex_tree, " << threads << " threads: " << static_cast<double>(message.size()) / seconds / 1e6
+				  << " MB/s, " << sequential / seconds << " times hortex" << std::endl;
+		if (threads == thread_count) {
+			break;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef HORTEX_TREE_HPP
+#define HORTEX_TREE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "elm_batch.hpp"
+#include "hortex.hpp"
+#include "hortex_many.hpp"
+
+// Tree mode of hortex for long messages. The message is split into chunks of 2^chunk_log2 bytes (the last one may be
+// shorter, an empty message is one empty chunk). Every chunk is hashed into a 16-byte chaining value by a leaf, and a
+// root node hashes the chaining values in chunk order followed by the message length in bytes as a 64-bit big-endian
+// number. Leaves and root are the sponge of hortex with its padding, but they start from their own initial states
+// instead of the all-zero state: the capacity words hold the node type, chunk_log2 and, for leaves, the chunk index.
+// This separates the leaves, the root and sequential hortex from each other and binds every chaining value to its
+// position. The digest therefore differs from hortex of the same message, which is unchanged.
+//
+// The leaves are independent: the threads take groups of up to HORTEX_MANY_LANES chunks from a shared counter and
+// hash each group with hortex_many, so a thread also keeps the SIMD lanes of ELM_batch busy. Only the root, one
+// fFunction call per 8 bytes of chaining values, runs on the calling thread.
+
+constexpr int HORTEX_TREE_DEFAULT_CHUNK_LOG2 = 16;
+constexpr int HORTEX_TREE_MIN_CHUNK_LOG2 = 3;
+constexpr int HORTEX_TREE_MAX_CHUNK_LOG2 = 40;
+
+// Node types in the capacity of the initial states
+constexpr uint32_t HORTEX_TREE_LEAF = 1;
+constexpr uint32_t HORTEX_TREE_ROOT = 2;
+
+inline State hortex_tree_leaf_state(const uint64_t chunk, const int chunk_log2) {
+    return {0, 0, 0, 0, HORTEX_TREE_LEAF, static_cast<uint32_t>(chunk_log2), static_cast<uint32_t>(chunk >> 32),
+            static_cast<uint32_t>(chunk)};
+}
+
+inline State hortex_tree_root_state(const int chunk_log2) {
+    return {0, 0, 0, 0, HORTEX_TREE_ROOT, static_cast<uint32_t>(chunk_log2), 0, 0};
+}
+
+inline std::size_t hortex_tree_chunk_count(const std::size_t len, const int chunk_log2) {
+    return len == 0 ? 1 : ((len - 1) >> chunk_log2) + 1;
+}
+
+// Writes the 16-byte digest of the tree mode. thread_count threads hash the leaves, including the calling thread.
+template<typename I>
+void hortex_tree(const uint8_t *data, const std::size_t len, uint8_t *digest,
+                 const int chunk_log2 = HORTEX_TREE_DEFAULT_CHUNK_LOG2, const unsigned thread_count = 1,
+                 const ELMBackend backend = detected_backend()) {
+    const std::size_t chunk_size = std::size_t{1} << chunk_log2;
+    const std::size_t chunk_count = hortex_tree_chunk_count(len, chunk_log2);
+
+    // Groups of up to HORTEX_MANY_LANES chunks, smaller if that leaves threads without work
+    const std::size_t group_size = std::clamp<std::size_t>(chunk_count / std::max(1u, thread_count), 1, HORTEX_MANY_LANES);
+    const std::size_t group_count = (chunk_count + group_size - 1) / group_size;
+
+    std::vector<uint8_t> chaining_values(Hortex<I>::digest_size * chunk_count);
+    std::atomic<std::size_t> next_group{0};
+
+    auto hash_leaves = [&] {
+        HortexMessage chunks[HORTEX_MANY_LANES];
+        State states[HORTEX_MANY_LANES];
+        for (std::size_t group = next_group++; group < group_count; group = next_group++) {
+            const std::size_t first = group * group_size;
+            const std::size_t count = std::min(group_size, chunk_count - first);
+            for (std::size_t i = 0; i < count; i++) {
+                const std::size_t offset = (first + i) * chunk_size;
+                chunks[i] = {data + offset, std::min(chunk_size, len - offset)};
+                states[i] = hortex_tree_leaf_state(first + i, chunk_log2);
+            }
+            hortex_many<I>(chunks, count, chaining_values.data() + Hortex<I>::digest_size * first, backend, states);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < std::min<std::size_t>(thread_count, group_count); t++) {
+        threads.emplace_back(hash_leaves);
+    }
+    hash_leaves();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    Hortex<I> root(hortex_tree_root_state(chunk_log2));
+    root.update(chaining_values.data(), chaining_values.size());
+    uint64_t length = len;
+    if constexpr (std::endian::native == std::endian::little) {
+        length = std::byteswap(length);
+    }
+    root.update(reinterpret_cast<const uint8_t *>(&length), sizeof(length));
+    root.final(digest);
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "arguments.hpp"
+#include "elm_batch.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "hortex_tree.hpp"
+#include "sweep.hpp"
+
+// Prints or checks the hortex digests of files in the format of sha256sum. Regular files are mapped into memory and
+// hashed in place, stdin ("-" or no file) and other files that cannot be mapped are read in aligned blocks of
+// HORTEXSUM_READ_SIZE bytes. Several files are hashed at the same time by a pool of threads, the lines are printed in
+// the order of the files. At the end the number of bytes per second is printed to std::cerr, to compare the ELM
+// backends on real data.
+//
+// ./hortexsum [options] [file...]
+//
+//   -c, --check             reads digest lines from the files and checks the digests of the listed files
+//   -t, --threads <n>       threads hashing files, default: number of hardware threads
+//   -i, --interpretation <use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx]>
+//                           default: true,3,false,true
+//   --elm-table <file>      evaluates ELM with a table written by generate_elm_table
+//   --tree                  tree mode of hortex_tree.hpp instead of sequential hortex
+//   --chunk-log2 <n>        chunk size of the tree mode, default: 16
+//   --backend <name>        ELM_batch backend of the tree mode (scalar, avx2, avx512), default: fastest supported
+
+constexpr std::size_t HORTEXSUM_READ_SIZE = std::size_t{1} << 20;
+constexpr std::size_t HORTEXSUM_READ_ALIGNMENT = 4096;
+
+struct HortexsumOptions {
+	bool check = false;
+	unsigned thread_count = default_thread_count();
+	int interpretation = DefaultInterpretation::id;
+	std::string table_path;
+	bool tree = false;
+	int chunk_log2 = HORTEX_TREE_DEFAULT_CHUNK_LOG2;
+	ELMBackend backend = detected_backend();
+};
+
+// One file to hash, and for --check its expected digest
+struct HashJob {
+	std::string name;
+	std::string expected;
+
+	bool done = false;
+	bool read = false;
+	std::string digest;
+	std::string error;
+	uint64_t bytes = 0;
+};
+
+inline std::string to_hex(const uint8_t *bytes, const std::size_t len) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (std::size_t i = 0; i < len; i++) {
+		ss << std::setw(2) << static_cast<int>(bytes[i]);
+	}
+	return ss.str();
+}
+
+// Reads up to len bytes, fewer only at the end of the input. Returns -1 on errors.
+inline ssize_t read_fully(const int fd, uint8_t *buffer, const std::size_t len) {
+	std::size_t total = 0;
+	while (total < len) {
+		const ssize_t n = ::read(fd, buffer + total, len - total);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return -1;
+		}
+		if (n == 0) {
+			break;
+		}
+		total += static_cast<std::size_t>(n);
+	}
+	return static_cast<ssize_t>(total);
+}
+
+// Hashes one input with sequential hortex or the tree mode
+template<typename I, typename E>
+class FileHasher {
+public:
+	FileHasher(const HortexsumOptions &options, const E &elm, const unsigned tree_thread_count)
+		: options(options), elm(elm), tree_thread_count(tree_thread_count),
+		  buffer(static_cast<uint8_t *>(std::aligned_alloc(HORTEXSUM_READ_ALIGNMENT, HORTEXSUM_READ_SIZE)), &std::free) {
+		if (!buffer) {
+			throw std::bad_alloc();
+		}
+	}
+
+	void hash(HashJob &job) {
+		const bool standard_input = job.name == "-";
+		const int fd = standard_input ? STDIN_FILENO : ::open(job.name.c_str(), O_RDONLY);
+		if (fd < 0) {
+			job.error = std::strerror(errno);
+			return;
+		}
+
+		uint8_t digest[Hortex<I>::digest_size];
+		struct stat status;
+		if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+			hash_mapped(fd, static_cast<std::size_t>(status.st_size), job, digest);
+		} else {
+			hash_stream(fd, job, digest);
+		}
+		if (!standard_input) {
+			::close(fd);
+		}
+		if (job.error.empty()) {
+			job.read = true;
+			job.digest = to_hex(digest, sizeof(digest));
+		}
+	}
+
+private:
+	const HortexsumOptions &options;
+	E elm;
+	unsigned tree_thread_count;
+	std::unique_ptr<uint8_t, decltype(&std::free)> buffer;
+	// Whole input of the tree mode when it cannot be mapped
+	std::vector<uint8_t> stream_bytes;
+
+	void hash_bytes(const uint8_t *data, const std::size_t len, uint8_t *digest) {
+		if (options.tree) {
+			hortex_tree<I>(data, len, digest, options.chunk_log2, tree_thread_count, options.backend);
+		} else {
+			Hortex<I, E> ctx(elm);
+			ctx.update(data, len);
+			ctx.final(digest);
+		}
+	}
+
+	void hash_mapped(const int fd, const std::size_t len, HashJob &job, uint8_t *digest) {
+		void *mapping = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			hash_stream(fd, job, digest);
+			return;
+		}
+		::madvise(mapping, len, MADV_SEQUENTIAL);
+		hash_bytes(static_cast<const uint8_t *>(mapping), len, digest);
+		::munmap(mapping, len);
+		job.bytes = len;
+	}
+
+	// Sequential hortex absorbs every block as it is read, the tree mode needs the length of the input before its root
+	// and collects the whole input first
+	void hash_stream(const int fd, HashJob &job, uint8_t *digest) {
+		Hortex<I, E> ctx(elm);
+		stream_bytes.clear();
+		for (;;) {
+			const ssize_t n = read_fully(fd, buffer.get(), HORTEXSUM_READ_SIZE);
+			if (n < 0) {
+				job.error = std::strerror(errno);
+				return;
+			}
+			if (options.tree) {
+				stream_bytes.insert(stream_bytes.end(), buffer.get(), buffer.get() + n);
+			} else {
+				ctx.update(buffer.get(), static_cast<std::size_t>(n));
+			}
+			job.bytes += static_cast<uint64_t>(n);
+			if (static_cast<std::size_t>(n) < HORTEXSUM_READ_SIZE) {
+				break;
+			}
+		}
+		if (options.tree) {
+			hortex_tree<I>(stream_bytes.data(), stream_bytes.size(), digest, options.chunk_log2, tree_thread_count,
+						   options.backend);
+		} else {
+			ctx.final(digest);
+		}
+	}
+};
+
+// Reads the lines "digest  name" of a check file, as printed by hortexsum. Returns false if it cannot be read.
+bool read_check_file(const std::string &path, std::vector<HashJob> &jobs, uint64_t &malformed) {
+	std::ifstream file_stream;
+	std::istream *stream = &std::cin;
+	if (path != "-") {
+		file_stream.open(path);
+		if (!file_stream) {
+			return false;
+		}
+		stream = &file_stream;
+	}
+
+	std::string line;
+	while (std::getline(*stream, line)) {
+		constexpr std::size_t digest_length = 2 * Hortex<DefaultInterpretation>::digest_size;
+		if (line.size() < digest_length + 3 || line[digest_length] != ' '
+			|| (line[digest_length + 1] != ' ' && line[digest_length + 1] != '*')
+			|| !std::all_of(line.begin(), line.begin() + digest_length, [](const unsigned char c) { return std::isxdigit(c); })) {
+			malformed++;
+			continue;
+		}
+		HashJob job;
+		job.expected = line.substr(0, digest_length);
+		std::transform(job.expected.begin(), job.expected.end(), job.expected.begin(),
+					   [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		job.name = line.substr(digest_length + 2);
+		jobs.push_back(std::move(job));
+	}
+	return true;
+}
+
+template<typename I, typename E>
+int run(const HortexsumOptions &options, std::vector<HashJob> &jobs, const E &elm) {
+	const unsigned worker_count = static_cast<unsigned>(std::min<std::size_t>(options.thread_count, jobs.size()));
+	// Threads left over when there are fewer files than threads hash the chunks of the tree mode
+	const unsigned tree_thread_count = std::max(1u, options.thread_count / std::max(1u, worker_count));
+
+	std::mutex mutex;
+	std::condition_variable job_done;
+	std::atomic<std::size_t> next_job{0};
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < worker_count; t++) {
+		workers.emplace_back([&] {
+			FileHasher<I, E> hasher(options, elm, tree_thread_count);
+			for (std::size_t j = next_job++; j < jobs.size(); j = next_job++) {
+				HashJob result = jobs[j];
+				hasher.hash(result);
+				{
+					const std::lock_guard<std::mutex> lock(mutex);
+					jobs[j] = std::move(result);
+					jobs[j].done = true;
+				}
+				job_done.notify_all();
+			}
+		});
+	}
+
+	int status = 0;
+	uint64_t bytes = 0, unreadable = 0, mismatches = 0;
+	for (HashJob &job : jobs) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_done.wait(lock, [&] { return job.done; });
+		}
+		bytes += job.bytes;
+
+		if (!job.read) {
+			std::cerr << "hortexsum: " << job.name << ": " << job.error << std::endl;
+			if (options.check) {
+				std::cout << job.name << ": FAILED open or read" << std::endl;
+			}
+			unreadable++;
+			status = 1;
+		} else if (options.check) {
+			const bool match = job.digest == job.expected;
+			std::cout << job.name << (match ? ": OK" : ": FAILED") << std::endl;
+			if (!match) {
+				mismatches++;
+				status = 1;
+			}
+		} else {
+			std::cout << job.digest << "  " << job.name << std::endl;
+		}
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (options.check && unreadable > 0) {
+		std::cerr << "hortexsum: WARNING: " << unreadable << " listed " << (unreadable == 1 ? "file" : "files")
+				  << " could not be read" << std::endl;
+	}
+	if (options.check && mismatches > 0) {
+		std::cerr << "hortexsum: WARNING: " << mismatches << " computed " << (mismatches == 1 ? "checksum" : "checksums")
+				  << " did NOT match" << std::endl;
+	}
+
+	const std::string elm_name = options.tree ? std::string("ELM_batch ") + backend_name(options.backend)
+								 : options.table_path.empty() ? "computed ELM" : "ELM table";
+	std::cerr << "hortexsum: " << jobs.size() << (jobs.size() == 1 ? " file, " : " files, ") << bytes << " bytes in "
+			  << seconds << " s, " << static_cast<double>(bytes) / std::max(seconds, 1e-9) / 1e6 << " MB/s ("
+			  << interpretation_name(I::id) << ", " << (options.tree ? "tree mode, " : "") << elm_name << ", "
+			  << worker_count << (worker_count == 1 ? " thread" : " threads") << ")" << std::endl;
+	return status;
+}
+
+int main(int argc, char *argv[]) {
+	HortexsumOptions options;
+	std::vector<std::string> names;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		unsigned long long number;
+		if (arg == "-c" || arg == "--check") {
+			options.check = true;
+		} else if ((arg == "-t" || arg == "--threads") && has_value && parse_number(argv[i + 1], 1, 4096, number)) {
+			options.thread_count = static_cast<unsigned>(number);
+			i++;
+		} else if ((arg == "-i" || arg == "--interpretation") && has_value && parse_interpretation(argv[i + 1], options.interpretation)) {
+			i++;
+		} else if (arg == "--elm-table" && has_value) {
+			options.table_path = argv[++i];
+		} else if (arg == "--tree") {
+			options.tree = true;
+		} else if (arg == "--chunk-log2" && has_value
+				   && parse_number(argv[i + 1], HORTEX_TREE_MIN_CHUNK_LOG2, HORTEX_TREE_MAX_CHUNK_LOG2, number)) {
+			options.chunk_log2 = static_cast<int>(number);
+			i++;
+		} else if (arg == "--backend" && has_value) {
+			const std::string_view name = argv[++i];
+			if (name == "scalar") {
+				options.backend = ELMBackend::Scalar;
+			} else if (name == "avx2") {
+				options.backend = ELMBackend::AVX2;
+			} else if (name == "avx512") {
+				options.backend = ELMBackend::AVX512;
+			} else {
+				std::cerr << "Please provide scalar, avx2 or avx512, for --backend." << std::endl;
+				return 1;
+			}
+			if (!backend_supported(options.backend)) {
+				std::cerr << "The backend " << name << " is not supported by this CPU." << std::endl;
+				return 1;
+			}
+		} else if (arg.size() > 1 && arg[0] == '-' && arg != "--") {
+			std::cerr << "Unknown option or missing value: " << arg << std::endl;
+			std::cerr << "Usage: hortexsum [--check] [--threads n] [--interpretation i] [--elm-table file] [--tree] [--chunk-log2 n] [--backend name] [file...]" << std::endl;
+			return 1;
+		} else if (arg == "--") {
+			for (i++; i < argc; i++) {
+				names.emplace_back(argv[i]);
+			}
+		} else {
+			names.emplace_back(arg);
+		}
+	}
+	if (names.empty()) {
+		names.emplace_back("-");
+	}
+	if (options.tree && !options.table_path.empty()) {
+		std::cerr << "The tree mode evaluates ELM with ELM_batch and takes no --elm-table." << std::endl;
+		return 1;
+	}
+
+	std::vector<HashJob> jobs;
+	uint64_t malformed = 0;
+	if (options.check) {
+		for (const std::string &name : names) {
+			if (!read_check_file(name, jobs, malformed)) {
+				std::cerr << "hortexsum: " << name << ": " << std::strerror(errno) << std::endl;
+				return 1;
+			}
+		}
+		if (malformed > 0) {
+			std::cerr << "hortexsum: WARNING: " << malformed << (malformed == 1 ? " line is" : " lines are")
+					  << " improperly formatted" << std::endl;
+		}
+		if (jobs.empty()) {
+			std::cerr << "hortexsum: no properly formatted checksum lines found" << std::endl;
+			return 1;
+		}
+	} else {
+		for (const std::string &name : names) {
+			HashJob job;
+			job.name = name;
+			jobs.push_back(std::move(job));
+		}
+	}
+
+	std::unique_ptr<ELMTable> table;
+	if (!options.table_path.empty()) {
+		try {
+			table = std::make_unique<ELMTable>(options.table_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	int status = 1;
+	with_interpretation(options.interpretation, [&]<typename I>(I) {
+		if (!table) {
+			status = run<I>(options, jobs, ComputedELM<I>{});
+			return;
+		}
+		try {
+			status = run<I>(options, jobs, table->evaluator<I>());
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+		}
+	});
+	return status;
+}
@@ -0,0 +1,190 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+// Optional instrumentation of the scalar ELM and fFunction in hortex.hpp. Compiling with -DHORTEX_INSTRUMENTATION=1
+// records
+//
+//   - the histogram of the iteration count n of every ELM call
+//   - the cycles of the ELM chain, the ARX layer and the state packing of fFunction (conversions between State,
+//     std::bitset, message blocks and the digest)
+//
+// and -DHORTEX_INSTRUMENTATION=2 additionally the cycles of every exp2, modf and binary32 step of ELM. The stages are
+// measured inclusively, so on level 2 the ELM chain also contains the cost of measuring its steps; level 1 gives the
+// undisturbed split of fFunction. Every thread counts in its own thread_local counters, which are added to a global
+// report when the thread ends, and the report is printed to std::cerr at exit. The cycles are read with rdtsc, the
+// cost of one measurement is estimated at exit and subtracted.
+//
+// Without HORTEX_INSTRUMENTATION all macros expand to nothing, or to the measured expression itself, so the
+// instrumented code compiles exactly as before. The batch backends in elm_batch.hpp are not instrumented.
+
+#ifndef HORTEX_INSTRUMENTATION
+#define HORTEX_INSTRUMENTATION 0
+#endif
+
+#if HORTEX_INSTRUMENTATION
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+enum class InstrumentedStage {
+    Exp2,
+    Modf,
+    Binary32,
+    ELMChain,
+    ARX,
+    Packing,
+    Count
+};
+
+constexpr const char *INSTRUMENTED_STAGE_NAMES[] = {"exp2", "modf", "binary32", "ELM chain", "ARX", "packing"};
+constexpr int INSTRUMENTED_STAGE_COUNT = static_cast<int>(InstrumentedStage::Count);
+
+// n = floor(6 * gamma) with gamma in [0, 1]
+constexpr int INSTRUMENTED_MAX_N = 6;
+
+inline uint64_t instrumentation_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct InstrumentationCounters {
+    std::array<uint64_t, INSTRUMENTED_MAX_N + 1> n_histogram{};
+    std::array<uint64_t, INSTRUMENTED_STAGE_COUNT> calls{};
+    std::array<uint64_t, INSTRUMENTED_STAGE_COUNT> cycles{};
+
+    void add(const InstrumentationCounters &other) {
+        for (int n = 0; n <= INSTRUMENTED_MAX_N; n++) {
+            n_histogram[n] += other.n_histogram[n];
+        }
+        for (int s = 0; s < INSTRUMENTED_STAGE_COUNT; s++) {
+            calls[s] += other.calls[s];
+            cycles[s] += other.cycles[s];
+        }
+    }
+};
+
+// Sum over all threads that have ended, printed when the program exits
+class InstrumentationReport {
+public:
+    static InstrumentationReport &instance() {
+        static InstrumentationReport report;
+        return report;
+    }
+
+    void add(const InstrumentationCounters &counters) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        total.add(counters);
+    }
+
+    ~InstrumentationReport() {
+        const double overhead = measurement_overhead();
+        const uint64_t elm_calls = [&] {
+            uint64_t sum = 0;
+            for (const uint64_t count : total.n_histogram) {
+                sum += count;
+            }
+            return sum;
+        }();
+
+        std::cerr << "Instrumentation (level " << HORTEX_INSTRUMENTATION << ", " << overhead
+                  << " cycles per measurement subtracted):" << std::endl;
+        std::cerr << "  ELM calls by n:" << std::endl;
+        for (int n = 0; n <= INSTRUMENTED_MAX_N; n++) {
+            std::cerr << "    n = " << n << ": " << total.n_histogram[n] << " (" << std::fixed << std::setprecision(2)
+                      << (elm_calls > 0 ? 100.0 * static_cast<double>(total.n_histogram[n]) / static_cast<double>(elm_calls) : 0)
+                      << " %, " << n + 2 << " fELM iterations)" << std::defaultfloat << std::endl;
+        }
+        std::cerr << "  Stages:" << std::endl;
+        for (int s = 0; s < INSTRUMENTED_STAGE_COUNT; s++) {
+            if (total.calls[s] == 0) {
+                continue;
+            }
+            const double cycles = std::max(0.0, static_cast<double>(total.cycles[s]) - overhead * static_cast<double>(total.calls[s]));
+            std::cerr << "    " << INSTRUMENTED_STAGE_NAMES[s] << ": " << total.calls[s] << " calls, "
+                      << cycles / static_cast<double>(total.calls[s]) << " cycles per call, " << cycles << " cycles" << std::endl;
+        }
+    }
+
+private:
+    InstrumentationReport() = default;
+
+    // Smallest difference of two consecutive readings
+    static double measurement_overhead() {
+        uint64_t smallest = ~uint64_t{0};
+        for (int i = 0; i < 1000; i++) {
+            const uint64_t start = instrumentation_cycles();
+            smallest = std::min(smallest, instrumentation_cycles() - start);
+        }
+        return static_cast<double>(smallest);
+    }
+
+    std::mutex mutex;
+    InstrumentationCounters total;
+};
+
+struct ThreadInstrumentation {
+    InstrumentationCounters counters;
+
+    // The report is created first, so it is destroyed after the counters of all threads, including the main thread
+    ThreadInstrumentation() {
+        InstrumentationReport::instance();
+    }
+
+    ~ThreadInstrumentation() {
+        InstrumentationReport::instance().add(counters);
+    }
+};
+
+inline InstrumentationCounters &thread_instrumentation() {
+    thread_local ThreadInstrumentation instrumentation;
+    return instrumentation.counters;
+}
+
+inline void record_stage(const InstrumentedStage stage, const uint64_t start) {
+    const uint64_t end = instrumentation_cycles();
+    InstrumentationCounters &counters = thread_instrumentation();
+    counters.calls[static_cast<int>(stage)]++;
+    counters.cycles[static_cast<int>(stage)] += end - start;
+}
+
+template<typename F>
+inline auto measure_stage(const InstrumentedStage stage, F &&f) {
+    const uint64_t start = instrumentation_cycles();
+    const auto result = f();
+    record_stage(stage, start);
+    return result;
+}
+
+#define HORTEX_COUNT_N(n) (thread_instrumentation().n_histogram[(n)]++)
+#define HORTEX_STAGE_BEGIN(stage) const uint64_t hortex_stage_start_##stage = instrumentation_cycles()
+#define HORTEX_STAGE_END(stage) record_stage(InstrumentedStage::stage, hortex_stage_start_##stage)
+
+#else
+
+#define HORTEX_COUNT_N(n) static_cast<void>(0)
+#define HORTEX_STAGE_BEGIN(stage) static_cast<void>(0)
+#define HORTEX_STAGE_END(stage) static_cast<void>(0)
+
+#endif
+
+// The value of expression, on level 2 measured as the given stage
+#if HORTEX_INSTRUMENTATION >= 2
+#define HORTEX_MEASURE(stage, expression) measure_stage(InstrumentedStage::stage, [&] { return (expression); })
+#else
+#define HORTEX_MEASURE(stage, expression) (expression)
+#endif
+
+#endif
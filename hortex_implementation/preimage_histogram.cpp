@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "arguments.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Prints how many outputs of ELM have 0, 1, 2, ... preimages over all 2^32 inputs.
+template<typename I, int Bits>
+void preimage_histogram(unsigned thread_count, std::size_t top_count, const ELMTable *table) {
+	const uint32_t *table_outputs = table ? table->evaluator<I>().outputs : nullptr;
+	const PreimageHistogram histogram = preimage_histogram_sweep<I, Bits>(thread_count, top_count, table_outputs);
+	const std::size_t saturated = histogram.outputs.size() - 1;
+
+	std::cout << "Preimages  Outputs" << std::endl;
+	for (std::size_t m = 0; m < histogram.outputs.size(); m++) {
+		const std::string label = std::to_string(m) + (m == saturated ? "+" : "");
+		std::cout << label << std::string(11 - label.size(), ' ') << histogram.outputs[m] << std::endl;
+	}
+
+	std::cout << "Image size: " << ELM_DOMAIN_SIZE - histogram.outputs[0] << " of " << ELM_DOMAIN_SIZE << " outputs." << std::endl;
+
+	for (const auto &[output, preimages] : histogram.top_outputs) {
+		std::cout << "Output " << output << " has " << preimages << " preimages." << std::endl;
+	}
+}
+
+// Runs the sweep with 2-bit and with 4-bit counters and checks that both give the same histogram up to the
+// saturation of 2 bits and the same top_count outputs with the same exact preimage counts. The 2-bit run saturates
+// at 3 preimages, so its top outputs are always resolved by counting all saturated outputs exactly.
+template<typename I>
+bool compare_counter_widths(unsigned thread_count, std::size_t top_count, const ELMTable *table) {
+	const uint32_t *table_outputs = table ? table->evaluator<I>().outputs : nullptr;
+	const PreimageHistogram narrow = preimage_histogram_sweep<I, 2>(thread_count, top_count, table_outputs);
+	const PreimageHistogram wide = preimage_histogram_sweep<I, 4>(thread_count, top_count, table_outputs);
+
+	uint64_t wide_saturated = 0;
+	for (std::size_t m = 3; m < wide.outputs.size(); m++) {
+		wide_saturated += wide.outputs[m];
+	}
+	const bool histogram_match = narrow.outputs[0] == wide.outputs[0] && narrow.outputs[1] == wide.outputs[1]
+								 && narrow.outputs[2] == wide.outputs[2] && narrow.outputs[3] == wide_saturated;
+	const bool top_match = narrow.top_outputs == wide.top_outputs;
+
+	std::cout << "Histograms of 2-bit and 4-bit counters: " << (histogram_match ? "Match" : "Mismatch") << std::endl;
+	std::cout << "Top " << top_count << " outputs of 2-bit and 4-bit counters: " << (top_match ? "Match" : "Mismatch") << std::endl;
+	for (std::size_t i = 0; i < std::max(narrow.top_outputs.size(), wide.top_outputs.size()); i++) {
+		std::cout << "  ";
+		if (i < narrow.top_outputs.size()) {
+			std::cout << "Output " << narrow.top_outputs[i].first << " has " << narrow.top_outputs[i].second << " preimages";
+		}
+		if (i < wide.top_outputs.size() && (i >= narrow.top_outputs.size() || narrow.top_outputs[i] != wide.top_outputs[i])) {
+			std::cout << ", 4 bits: output " << wide.top_outputs[i].first << " has " << wide.top_outputs[i].second << " preimages";
+		}
+		std::cout << "." << std::endl;
+	}
+	return histogram_match && top_match;
+}
+
+int main(int argc, char *argv[]) {
+	int interpretation = DefaultInterpretation::id;
+
+	if (argc >= 2 && !parse_interpretation(argv[1], interpretation)) {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false), for the first argument." << std::endl;
+		return 0;
+	}
+
+	unsigned long long counter_bits = 4;
+	const bool compare = argc >= 3 && std::string(argv[2]) == "compare";
+
+	if (argc >= 3 && !compare && (!parse_number(argv[2], 2, 4, counter_bits) || counter_bits == 3)) {
+		std::cerr << "Please provide the value 2, 4 or compare, for the second argument." << std::endl;
+		return 0;
+	}
+
+	unsigned long long thread_count = default_thread_count();
+
+	if (argc >= 4 && !parse_number(argv[3], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	unsigned long long top_count = compare ? 10 : 0;
+
+	if (argc >= 5 && !parse_number(argv[4], 0, 1000000, top_count)) {
+		std::cerr << "Please provide a number from 0 to 1000000, for the fourth argument." << std::endl;
+		return 0;
+	}
+
+	// Optional table generated by generate_elm_table, read instead of computing ELM
+	std::unique_ptr<ELMTable> table;
+
+	if (argc >= 6) {
+		try {
+			table = std::make_unique<ELMTable>(argv[5], ELMTableAccess::Sequential);
+			if ((table->interpretation() | 1) != (interpretation | 1)) {
+				throw std::runtime_error("The ELM table was generated for another interpretation");
+			}
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Please provide an ELM table of the chosen interpretation, for the fifth argument." << std::endl;
+			return 0;
+		}
+	}
+
+	std::cout << "Interpretation: " << interpretation_name(interpretation, false) << std::endl;
+
+	int status = 0;
+	with_elm_interpretation(interpretation, [&]<typename I>(I) {
+		if (compare) {
+			status = compare_counter_widths<I>(thread_count, top_count, table.get()) ? 0 : 1;
+		} else if (counter_bits == 2) {
+			preimage_histogram<I, 2>(thread_count, top_count, table.get());
+		} else {
+			preimage_histogram<I, 4>(thread_count, top_count, table.get());
+		}
+	});
+
+	return status;
+}
@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "arguments.hpp"
+#include "hortex.hpp"
+#include "preimage_index.hpp"
+#include "sweep.hpp"
+
+// Builds the index of all preimages of an ELM interpretation, or looks up the preimages of outputs in such an index.
+//
+// ./preimage_index build <interpretation> <index_file> <temp_directory> <memory_mib> <threads>
+// ./preimage_index query <index_file> <output> [<output> ...]
+
+int build(int argc, char *argv[]) {
+	int interpretation = DefaultInterpretation::id;
+
+	if (argc < 5 || !parse_interpretation(argv[2], interpretation)) {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false), the index file and a directory for temporary files." << std::endl;
+		return 0;
+	}
+
+	unsigned long long memory_mib = 2048;
+
+	if (argc >= 6 && !parse_number(argv[5], 64, 1ULL << 30, memory_mib)) {
+		std::cerr << "Please provide the memory budget in MiB (at least 64), for the fifth argument." << std::endl;
+		return 0;
+	}
+
+	unsigned long long thread_count = default_thread_count();
+
+	if (argc >= 7 && !parse_number(argv[6], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the sixth argument." << std::endl;
+		return 0;
+	}
+
+	PreimageIndexBuilder builder(argv[3], argv[4], memory_mib << 20, thread_count);
+	with_elm_interpretation(interpretation, [&]<typename I>(I) { builder.build<I>(); });
+
+	std::cout << "Preimage index of the interpretation " << interpretation_name(interpretation, false) << " written to " << argv[3] << "." << std::endl;
+	return 0;
+}
+
+int query(int argc, char *argv[]) {
+	if (argc < 4) {
+		std::cerr << "Please provide the index file and at least one output." << std::endl;
+		return 0;
+	}
+
+	const PreimageIndex index(argv[2]);
+	std::cout << "Interpretation: " << interpretation_name(index.interpretation(), false) << std::endl;
+
+	for (int i = 3; i < argc; i++) {
+		unsigned long long y;
+		if (!parse_number(argv[i], 0, UINT32_MAX, y)) {
+			std::cerr << argv[i] << " is not an output of ELM." << std::endl;
+			continue;
+		}
+
+		const auto preimages = index.preimages(static_cast<uint32_t>(y));
+		std::cout << "Output " << y << " has " << preimages.size() << " preimages:";
+		for (const uint32_t x : preimages) {
+			std::cout << " " << x;
+		}
+		std::cout << std::endl;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	const std::string mode = argc >= 2 ? argv[1] : "";
+
+	try {
+		if (mode == "build") {
+			return build(argc, argv);
+		} else if (mode == "query") {
+			return query(argc, argv);
+		}
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cerr << "Please provide either build or query, for the first argument." << std::endl;
+	return 0;
+}
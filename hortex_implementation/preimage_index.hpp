@@ -0,0 +1,431 @@
+#ifndef PREIMAGE_INDEX_HPP
+#define PREIMAGE_INDEX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file_io.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// On-disk index of all preimages of ELM<I>. The file consists of
+//
+//   header   4096 bytes, see PreimageIndexHeader
+//   offsets  2^32 x uint32, offsets[y] = number of inputs whose output is smaller than y (mod 2^32)
+//   inputs   2^32 x uint32, all inputs sorted by (output, input)
+//
+// so the preimages of y are inputs[offsets[y] .. offsets[y + 1]) and can be looked up in O(1) after mapping the file.
+// The offsets are stored modulo 2^32, which is unambiguous as long as no output has all 2^32 inputs as preimages.
+//
+// The index is built by an external radix sort: the (output, input) pairs are computed on all threads and
+// partitioned by the most significant byte of the output into 256 temporary files, while a writer thread appends
+// full buffers to the files. The buckets are then sorted in memory on all threads and written to their final
+// positions. A bucket that does not fit into its share of the memory budget is partitioned again by the next byte.
+
+struct PreimageIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t interpretation;
+    uint64_t offsets_position;
+    uint64_t inputs_position;
+};
+
+constexpr char PREIMAGE_INDEX_MAGIC[8] = {'H', 'R', 'T', 'X', 'P', 'I', 'D', 'X'};
+constexpr uint32_t PREIMAGE_INDEX_VERSION = 1;
+constexpr uint64_t PREIMAGE_INDEX_HEADER_SIZE = 4096;
+
+// Temporary file of (output << 32 | input) pairs
+class PairFile {
+public:
+    explicit PairFile(std::string file_path) : path(std::move(file_path)) {
+        file = std::fopen(path.c_str(), "w+b");
+        if (file == nullptr) {
+            throw std::runtime_error("Could not create " + path);
+        }
+    }
+
+    PairFile(const PairFile &) = delete;
+    PairFile &operator=(const PairFile &) = delete;
+
+    ~PairFile() {
+        std::fclose(file);
+        std::remove(path.c_str());
+    }
+
+    void append(const uint64_t *pairs, const std::size_t count) {
+        if (std::fwrite(pairs, sizeof(uint64_t), count, file) != count) {
+            throw std::runtime_error("Writing " + path + " failed");
+        }
+        pair_count += count;
+    }
+
+    void read_all(std::vector<uint64_t> &pairs) {
+        std::fflush(file);
+        std::rewind(file);
+        pairs.resize(pair_count);
+        if (std::fread(pairs.data(), sizeof(uint64_t), pair_count, file) != pair_count) {
+            throw std::runtime_error("Reading " + path + " failed");
+        }
+    }
+
+    // Calls f(pairs, count) for consecutive blocks of the file
+    template<typename F>
+    void for_each_block(F &&f) {
+        std::fflush(file);
+        std::rewind(file);
+        std::vector<uint64_t> block(1 << 20);
+        std::size_t count;
+        while ((count = std::fread(block.data(), sizeof(uint64_t), block.size(), file)) > 0) {
+            f(block.data(), count);
+        }
+    }
+
+    uint64_t size() const {
+        return pair_count;
+    }
+
+private:
+    std::string path;
+    std::FILE *file;
+    uint64_t pair_count = 0;
+};
+
+class PreimageIndexBuilder {
+public:
+    PreimageIndexBuilder(const std::string &index_path, std::string temp_directory, const uint64_t memory_budget,
+                         const unsigned thread_count)
+        : temp_directory(std::move(temp_directory)), thread_count(thread_count),
+          bucket_capacity(std::max<uint64_t>(memory_budget / thread_count / BYTES_PER_PAIR, 1 << 16)) {
+        fd = open(index_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Could not create " + index_path);
+        }
+    }
+
+    ~PreimageIndexBuilder() {
+        close(fd);
+    }
+
+    template<typename I>
+    void build() {
+        std::vector<std::unique_ptr<PairFile>> buckets = partition_outputs<I>();
+
+        // Position of the first input of every bucket in the inputs array
+        std::vector<uint64_t> bases(buckets.size() + 1, 0);
+        for (std::size_t b = 0; b < buckets.size(); b++) {
+            bases[b + 1] = bases[b] + buckets[b]->size();
+        }
+
+        std::atomic<std::size_t> next_bucket{0};
+        std::mutex error_mutex;
+        std::string error;
+
+        auto worker = [&] {
+            try {
+                std::size_t b;
+                while ((b = next_bucket.fetch_add(1)) < buckets.size()) {
+                    sort_bucket(*buckets[b], b, 1, bases[b]);
+                    buckets[b].reset();
+                }
+            } catch (const std::exception &e) {
+                const std::lock_guard<std::mutex> lock(error_mutex);
+                error = e.what();
+                next_bucket = buckets.size();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < thread_count; t++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+
+        PreimageIndexHeader header{};
+        std::memcpy(header.magic, PREIMAGE_INDEX_MAGIC, sizeof(header.magic));
+        header.version = PREIMAGE_INDEX_VERSION;
+        header.interpretation = I::id;
+        header.offsets_position = PREIMAGE_INDEX_HEADER_SIZE;
+        header.inputs_position = PREIMAGE_INDEX_HEADER_SIZE + ELM_DOMAIN_SIZE * sizeof(uint32_t);
+        write_at(fd, &header, sizeof(header), 0);
+    }
+
+private:
+    static constexpr std::size_t BUFFER_PAIRS = 8192;
+
+    // Memory per pair while a bucket is sorted: the pair and its input in the output buffer
+    static constexpr uint64_t BYTES_PER_PAIR = 12;
+
+    std::string bucket_path(const uint64_t prefix, const int depth) const {
+        return temp_directory + "/hortex_preimage_bucket_" + std::to_string(depth) + "_" + std::to_string(prefix) + ".tmp";
+    }
+
+    // Computes all (output, input) pairs and appends them to 256 files by the most significant byte of the output.
+    // Full buffers are handed to a writer thread, so computing and writing overlap.
+    template<typename I>
+    std::vector<std::unique_ptr<PairFile>> partition_outputs() {
+        std::vector<std::unique_ptr<PairFile>> buckets;
+        for (uint64_t b = 0; b < 256; b++) {
+            buckets.push_back(std::make_unique<PairFile>(bucket_path(b, 1)));
+        }
+
+        struct Block {
+            std::size_t bucket;
+            std::vector<uint64_t> pairs;
+        };
+
+        std::mutex queue_mutex;
+        std::condition_variable queue_changed;
+        std::deque<Block> queue;
+        bool computing = true;
+        const std::size_t max_queued = 4 * 256;
+
+        std::string error;
+
+        std::thread writer([&] {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            while (computing || !queue.empty()) {
+                if (queue.empty()) {
+                    queue_changed.wait(lock);
+                    continue;
+                }
+                Block block = std::move(queue.front());
+                queue.pop_front();
+                queue_changed.notify_all();
+
+                lock.unlock();
+                try {
+                    buckets[block.bucket]->append(block.pairs.data(), block.pairs.size());
+                } catch (const std::exception &e) {
+                    error = e.what();
+                }
+                lock.lock();
+            }
+        });
+
+        auto enqueue = [&](const std::size_t bucket, std::vector<uint64_t> &pairs) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_changed.wait(lock, [&] { return queue.size() < max_queued; });
+            queue.push_back({bucket, std::move(pairs)});
+            queue_changed.notify_all();
+            pairs = std::vector<uint64_t>();
+            pairs.reserve(BUFFER_PAIRS);
+        };
+
+        std::vector<std::vector<std::vector<uint64_t>>> buffers(thread_count, std::vector<std::vector<uint64_t>>(256));
+
+        sweep_elm<I>(thread_count, [&](const unsigned t, const uint32_t *inputs, const uint32_t *outputs, const uint32_t count) {
+            for (uint32_t j = 0; j < count; j++) {
+                std::vector<uint64_t> &buffer = buffers[t][outputs[j] >> 24];
+                buffer.push_back(static_cast<uint64_t>(outputs[j]) << 32 | inputs[j]);
+                if (buffer.size() == BUFFER_PAIRS) {
+                    enqueue(outputs[j] >> 24, buffer);
+                }
+            }
+            return true;
+        });
+
+        for (auto &thread_buffers : buffers) {
+            for (std::size_t b = 0; b < 256; b++) {
+                if (!thread_buffers[b].empty()) {
+                    enqueue(b, thread_buffers[b]);
+                }
+            }
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock(queue_mutex);
+            computing = false;
+        }
+        queue_changed.notify_all();
+        writer.join();
+
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+
+        return buckets;
+    }
+
+    // Writes offsets[first_output .. first_output + count) for outputs that all start at the same input position
+    void fill_offsets(const uint64_t first_output, const uint64_t count, const uint64_t position) {
+        std::vector<uint32_t> block(std::min<uint64_t>(count, 1 << 20), static_cast<uint32_t>(position));
+        for (uint64_t done = 0; done < count; done += block.size()) {
+            const uint64_t n = std::min<uint64_t>(block.size(), count - done);
+            write_at(fd, block.data(), n * sizeof(uint32_t), PREIMAGE_INDEX_HEADER_SIZE + (first_output + done) * sizeof(uint32_t));
+        }
+    }
+
+    // Sorts the pairs whose key starts with the depth most significant bytes prefix. Their inputs are written from
+    // position base on. For depth <= 4 the key prefix is a range of outputs, whose offsets are written as well.
+    void sort_bucket(PairFile &bucket, const uint64_t prefix, const int depth, const uint64_t base) {
+        const uint64_t output_count = depth <= 4 ? uint64_t{1} << (32 - 8 * depth) : 0;
+        const uint64_t first_output = depth <= 4 ? prefix << (32 - 8 * depth) : 0;
+
+        if (bucket.size() == ELM_DOMAIN_SIZE && depth == 4) {
+            throw std::runtime_error("ELM is constant, the index can not represent an output with 2^32 preimages");
+        }
+
+        if (bucket.size() <= bucket_capacity || depth == 8) {
+            std::vector<uint64_t> pairs;
+            bucket.read_all(pairs);
+            std::sort(pairs.begin(), pairs.end());
+
+            std::vector<uint32_t> inputs(pairs.size());
+            for (std::size_t i = 0; i < pairs.size(); i++) {
+                inputs[i] = static_cast<uint32_t>(pairs[i]);
+            }
+            write_at(fd, inputs.data(), inputs.size() * sizeof(uint32_t),
+                     PREIMAGE_INDEX_HEADER_SIZE + (ELM_DOMAIN_SIZE + base) * sizeof(uint32_t));
+
+            if (output_count > 0) {
+                std::vector<uint32_t> offsets(output_count);
+                std::size_t i = 0;
+                for (uint64_t y = 0; y < output_count; y++) {
+                    while (i < pairs.size() && (pairs[i] >> 32) < first_output + y) {
+                        i++;
+                    }
+                    offsets[y] = static_cast<uint32_t>(base + i);
+                }
+                write_at(fd, offsets.data(), offsets.size() * sizeof(uint32_t),
+                         PREIMAGE_INDEX_HEADER_SIZE + first_output * sizeof(uint32_t));
+            }
+            return;
+        }
+
+        // Too large for the memory budget: partition by the next byte of the key and sort the parts
+        if (depth == 4) {
+            fill_offsets(first_output, 1, base);
+        }
+
+        const int shift = 64 - 8 * (depth + 1);
+        std::vector<std::unique_ptr<PairFile>> parts(256);
+        std::vector<std::vector<uint64_t>> buffers(256);
+
+        bucket.for_each_block([&](const uint64_t *pairs, const std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+                const std::size_t part = pairs[i] >> shift & 0xFF;
+                buffers[part].push_back(pairs[i]);
+                if (buffers[part].size() == BUFFER_PAIRS) {
+                    if (!parts[part]) {
+                        parts[part] = std::make_unique<PairFile>(bucket_path(prefix << 8 | part, depth + 1));
+                    }
+                    parts[part]->append(buffers[part].data(), buffers[part].size());
+                    buffers[part].clear();
+                }
+            }
+        });
+
+        uint64_t position = base;
+        for (std::size_t part = 0; part < 256; part++) {
+            if (!buffers[part].empty()) {
+                if (!parts[part]) {
+                    parts[part] = std::make_unique<PairFile>(bucket_path(prefix << 8 | part, depth + 1));
+                }
+                parts[part]->append(buffers[part].data(), buffers[part].size());
+            }
+
+            if (parts[part]) {
+                const uint64_t size = parts[part]->size();
+                sort_bucket(*parts[part], prefix << 8 | part, depth + 1, position);
+                parts[part].reset();
+                position += size;
+            } else if (depth < 4) {
+                // Outputs without preimages all start at the current position
+                fill_offsets((prefix << 8 | part) << (32 - 8 * (depth + 1)), output_count / 256, position);
+            }
+        }
+    }
+
+    std::string temp_directory;
+    unsigned thread_count;
+    uint64_t bucket_capacity;
+    int fd;
+};
+
+// Read-only view of a preimage index file mapped into memory
+class PreimageIndex {
+public:
+    explicit PreimageIndex(const std::string &path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        struct stat status{};
+        fstat(fd, &status);
+        size = static_cast<std::size_t>(status.st_size);
+
+        const uint64_t expected_size = PREIMAGE_INDEX_HEADER_SIZE + 2 * ELM_DOMAIN_SIZE * sizeof(uint32_t);
+        if (size != expected_size) {
+            close(fd);
+            throw std::runtime_error(path + " is not a complete preimage index");
+        }
+
+        data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Could not map " + path);
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, PREIMAGE_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != PREIMAGE_INDEX_VERSION) {
+            munmap(data, size);
+            throw std::runtime_error(path + " is not a preimage index of this version");
+        }
+
+        offsets = reinterpret_cast<const uint32_t *>(static_cast<const uint8_t *>(data) + header.offsets_position);
+        inputs = reinterpret_cast<const uint32_t *>(static_cast<const uint8_t *>(data) + header.inputs_position);
+    }
+
+    PreimageIndex(const PreimageIndex &) = delete;
+    PreimageIndex &operator=(const PreimageIndex &) = delete;
+
+    ~PreimageIndex() {
+        munmap(data, size);
+    }
+
+    int interpretation() const {
+        return static_cast<int>(header.interpretation);
+    }
+
+    // All inputs x with ELM(x) = y in ascending order
+    std::span<const uint32_t> preimages(const uint32_t y) const {
+        const uint32_t begin = offsets[y];
+        const uint32_t end = y == UINT32_MAX ? 0 : offsets[y + 1];
+        return {inputs + begin, static_cast<uint32_t>(end - begin)};
+    }
+
+private:
+    PreimageIndexHeader header{};
+    void *data = nullptr;
+    std::size_t size = 0;
+    const uint32_t *offsets = nullptr;
+    const uint32_t *inputs = nullptr;
+};
+
+#endif
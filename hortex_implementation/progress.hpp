@@ -0,0 +1,237 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live progress of the sweeps and searches. The workers add to counters of their own thread, each on its own cache
+// line and only written by that thread, so counting costs a load and a store without any shared write. A reporter
+// thread sums the counters every interval and prints the rates, the collisions so far, the percentage and the
+// estimated remaining time to std::cerr, and optionally appends the same values as one JSON object per line to a file.
+
+// Counters of one worker thread
+struct alignas(64) ProgressCounters {
+    std::atomic<uint64_t> inputs{0};
+    std::atomic<uint64_t> elm_calls{0};
+    std::atomic<uint64_t> collisions{0};
+
+    // Only the owning thread writes, so a plain load and store replace a locked read-modify-write
+    static void add(std::atomic<uint64_t> &counter, const uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+// Description of one sweep or search passed to ProgressReporter::begin. Without total_inputs the percentage is taken
+// from total_collisions, without both there is no percentage and no ETA. completed_inputs and completed_collisions
+// count towards the percentage but not towards the rates, e.g. after resuming a checkpoint.
+struct ProgressGoal {
+    std::string label;
+    unsigned thread_count = 1;
+    uint64_t total_inputs = 0;
+    uint64_t total_collisions = 0;
+    uint64_t completed_inputs = 0;
+    uint64_t completed_collisions = 0;
+};
+
+class ProgressReporter {
+public:
+    // Reports every interval_seconds, json_path may be empty
+    explicit ProgressReporter(const double interval_seconds, const std::string &json_path = "")
+        : interval(interval_seconds) {
+        if (!json_path.empty()) {
+            json.open(json_path, std::ios::app);
+            if (!json) {
+                throw std::runtime_error("Could not open " + json_path);
+            }
+        }
+    }
+
+    ProgressReporter(const ProgressReporter &) = delete;
+    ProgressReporter &operator=(const ProgressReporter &) = delete;
+
+    ~ProgressReporter() {
+        end();
+    }
+
+    // Starts reporting a sweep or search, which the workers then count in counters(thread_index)
+    void begin(const ProgressGoal &progress_goal) {
+        end();
+        goal = progress_goal;
+        counters = std::make_unique<ProgressCounters[]>(goal.thread_count);
+        start_time = last_time = std::chrono::steady_clock::now();
+        last_inputs.assign(goal.thread_count, 0);
+        last_total = 0;
+        stopping = false;
+        reporter = std::thread([this] { report_periodically(); });
+    }
+
+    ProgressCounters &thread_counters(const unsigned thread_index) {
+        return counters[thread_index];
+    }
+
+    // Stops the reporter thread after a last report
+    void end() {
+        if (!reporter.joinable()) {
+            return;
+        }
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        stop_requested.notify_all();
+        reporter.join();
+        report(true);
+    }
+
+private:
+    std::chrono::duration<double> interval;
+    std::ofstream json;
+
+    ProgressGoal goal;
+    std::unique_ptr<ProgressCounters[]> counters;
+    std::chrono::steady_clock::time_point start_time, last_time;
+    // Inputs at the previous report, per thread and in total
+    std::vector<uint64_t> last_inputs;
+    uint64_t last_total = 0;
+
+    std::thread reporter;
+    std::mutex mutex;
+    std::condition_variable stop_requested;
+    bool stopping = false;
+
+    void report_periodically() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stop_requested.wait_for(lock, interval, [this] { return stopping; })) {
+            report(false);
+        }
+    }
+
+    void report(const bool final) {
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - start_time).count();
+        const double interval_seconds = std::max(std::chrono::duration<double>(now - last_time).count(), 1e-9);
+
+        uint64_t inputs = 0, elm_calls = 0, collisions = 0;
+        // Slowest thread in the last interval, to spot stragglers
+        double slowest_rate = -1;
+        for (unsigned t = 0; t < goal.thread_count; t++) {
+            const uint64_t thread_inputs = counters[t].inputs.load(std::memory_order_relaxed);
+            inputs += thread_inputs;
+            elm_calls += counters[t].elm_calls.load(std::memory_order_relaxed);
+            collisions += counters[t].collisions.load(std::memory_order_relaxed);
+
+            const double rate = static_cast<double>(thread_inputs - last_inputs[t]) / interval_seconds;
+            slowest_rate = slowest_rate < 0 ? rate : std::min(slowest_rate, rate);
+            last_inputs[t] = thread_inputs;
+        }
+
+        // Rates over the last interval, or over the whole run for the final report
+        const double rate_seconds = final ? std::max(seconds, 1e-9) : interval_seconds;
+        const double input_rate = static_cast<double>(final ? inputs : inputs - last_total) / rate_seconds;
+        const double elm_rate = final ? static_cast<double>(elm_calls) / rate_seconds
+                                      : input_rate * (inputs > 0 ? static_cast<double>(elm_calls) / static_cast<double>(inputs) : 0);
+        last_total = inputs;
+        last_time = now;
+
+        const uint64_t done_inputs = goal.completed_inputs + inputs;
+        const uint64_t done_collisions = goal.completed_collisions + collisions;
+
+        double fraction = -1, eta = -1;
+        if (goal.total_inputs > 0) {
+            fraction = static_cast<double>(done_inputs) / static_cast<double>(goal.total_inputs);
+            if (inputs > 0) {
+                eta = static_cast<double>(goal.total_inputs - std::min(done_inputs, goal.total_inputs)) * seconds / static_cast<double>(inputs);
+            }
+        } else if (goal.total_collisions > 0) {
+            fraction = static_cast<double>(done_collisions) / static_cast<double>(goal.total_collisions);
+            if (collisions > 0) {
+                eta = static_cast<double>(goal.total_collisions - std::min(done_collisions, goal.total_collisions)) * seconds / static_cast<double>(collisions);
+            }
+        }
+
+        std::ostringstream line;
+        line << std::setprecision(3) << goal.label << (final ? " finished after " : " after ") << seconds << " s: ";
+        if (fraction >= 0) {
+            line << 100 * fraction << " %, ";
+        }
+        line << done_inputs << " inputs, " << input_rate << " inputs/s, " << elm_rate << " ELM/s, " << done_collisions
+             << " collisions";
+        if (!final && goal.thread_count > 1) {
+            line << ", slowest thread " << slowest_rate << " inputs/s";
+        }
+        if (!final && eta >= 0) {
+            line << ", ETA " << eta << " s";
+        }
+        std::cerr << line.str() << std::endl;
+
+        if (json.is_open()) {
+            json << "{\"label\": \"" << goal.label << "\", \"final\": " << (final ? "true" : "false")
+                 << ", \"seconds\": " << seconds << ", \"inputs\": " << done_inputs << ", \"elm_calls\": " << elm_calls
+                 << ", \"collisions\": " << done_collisions << ", \"inputs_per_second\": " << input_rate
+                 << ", \"elm_per_second\": " << elm_rate << ", \"slowest_thread_inputs_per_second\": " << slowest_rate
+                 << ", \"percent\": ";
+            if (fraction >= 0) {
+                json << 100 * fraction;
+            } else {
+                json << "null";
+            }
+            json << ", \"eta_seconds\": ";
+            if (!final && eta >= 0) {
+                json << eta;
+            } else {
+                json << "null";
+            }
+            json << "}" << std::endl;
+        }
+    }
+};
+
+// Reports one sweep or search while it exists and does nothing without a reporter, so the sweeps take an optional
+// ProgressReporter pointer
+class ProgressRun {
+public:
+    ProgressRun(ProgressReporter *progress_reporter, const ProgressGoal &goal) : reporter(progress_reporter) {
+        if (reporter != nullptr) {
+            reporter->begin(goal);
+        }
+    }
+
+    ProgressRun(const ProgressRun &) = delete;
+    ProgressRun &operator=(const ProgressRun &) = delete;
+
+    ~ProgressRun() {
+        if (reporter != nullptr) {
+            reporter->end();
+        }
+    }
+
+    void add(const unsigned thread_index, const uint64_t inputs, const uint64_t elm_calls, const uint64_t collisions) {
+        if (reporter == nullptr) {
+            return;
+        }
+        ProgressCounters &counters = reporter->thread_counters(thread_index);
+        ProgressCounters::add(counters.inputs, inputs);
+        ProgressCounters::add(counters.elm_calls, elm_calls);
+        if (collisions > 0) {
+            ProgressCounters::add(counters.collisions, collisions);
+        }
+    }
+
+private:
+    ProgressReporter *reporter;
+};
+
+#endif
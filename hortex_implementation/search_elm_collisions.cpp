@@ -1,88 +1,117 @@
-#include <cmath>
-#include <vector>
+#include <cstdint>
+#include <exception>
 #include <iostream>
-#include <unordered_map>
-#include <random>
-
-// Logistic Map Function
-double fLM(const double eta, const double gamma) {
-    return eta * gamma * (1.0 - gamma);
-}
+#include <memory>
+#include <string>
+#include <vector>
 
-// Enhanced Logistic Map Function
-double fELM(const double eta, const double gamma, const double k) {
-    const double fLM_result = fLM(eta, gamma);
-    const double full_result = exp2(k - fLM_result);
+#include "arguments.hpp"
+#include "distinguished_points.hpp"
+#include "elm_table.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
 
-    double int_part;
-    const double fractional_part = modf(full_result, &int_part);
+// Distinguished points stored before the walk changes its salt, about 40 MiB
+constexpr uint64_t MAX_STORED_POINTS = uint64_t{1} << 20;
 
-    return fractional_part;
-}
+// Collision Search with distinguished points on all threads, elm evaluates ELM<I> by computation or by a table lookup
+template<typename I, typename E>
+void collision_search(const E &elm, const uint64_t collision_count, const unsigned thread_count, const int distinguished_bits,
+					  ProgressReporter *progress) {
+	const WalkStatistics statistics = distinguished_point_search(
+		thread_count, 32, distinguished_bits, MAX_STORED_POINTS, collision_count,
+		[&](const uint64_t x) { return uint64_t{elm(static_cast<uint32_t>(x))}; },
+		[](const WalkCollision &collision, const double seconds) {
+			std::cout << "Collision found! Input 1 = " << collision.a << " Input 2 = " << collision.b
+					  << " Output = " << collision.image << " (" << seconds << " s)" << std::endl;
+		}, progress);
 
-// Conversion of a real number to the binary representation of the IEEE single precision format
-uint32_t binary32(const double d) {
-    const auto f = static_cast<float>(d);
-    return std::bit_cast<uint32_t>(f);
+	std::cout << statistics.collisions << " collisions in " << statistics.seconds << " s, "
+			  << statistics.collisions / statistics.seconds << " collisions per second." << std::endl;
+	std::cout << statistics.steps << " ELM evaluations, " << statistics.distinguished_points << " distinguished points, "
+			  << statistics.repeated_collisions << " collisions found again, " << statistics.robin_hoods
+			  << " merges without collision, " << statistics.cycles << " trails ending in a cycle, "
+			  << statistics.abandoned_trails << " abandoned trails, "
+			  << statistics.salt_changes << " salt changes." << std::endl;
 }
 
-// ELM Algorithm
-uint32_t ELM(const uint32_t x) {
-    const uint16_t x_left = x >> 20;
-    const uint16_t x_middle = x >> 4 & 0xFFFF;
-    const uint16_t x_right = x & 0xF;
+// ./search_elm_collisions <interpretation> <collisions> <threads> <distinguished_bits> <table_file>
+//     [--progress <seconds>] [--progress-json <file>]
+int main(int argc, char *argv[]) {
+	ProgressOptions progress_options;
+	if (!take_progress_options(argc, argv, progress_options)) {
+		std::cerr << "Please provide --progress <seconds> (starting from 1) and --progress-json <file>." << std::endl;
+		return 0;
+	}
 
-    double gamma = x_left * (1.0 / 4095);
-    const double eta = x_middle * (2.0 / 65535) + 2.0;
-    const double k = x_right * (1.0 / 15) + 10.01;
+	std::vector<int> interpretations{DefaultInterpretation::id};
+	unsigned long long collision_count = 1;
+	unsigned long long thread_count = default_thread_count();
+	unsigned long long distinguished_bits = 8;
 
-    const int n = floor(6.0 * gamma);
+	if (argc >= 2) {
+		int interpretation;
+		if (std::string(argv[1]) == "all") {
+			interpretations.clear();
+			for (int id = 1; id < interpretation_count; id += 2) {
+				interpretations.push_back(id);
+			}
+		} else if (parse_interpretation(argv[1], interpretation)) {
+			interpretations = {interpretation};
+		} else {
+			std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or all, for the first argument." << std::endl;
+			return 0;
+		}
+	}
 
-    uint32_t w1 = 0, w2 = 0;
+	if (argc >= 3 && !parse_number(argv[2], 1, 1ull << 32, collision_count)) {
+		std::cerr << "Please provide a number starting from 1, for the second argument." << std::endl;
+		return 0;
+	}
 
-    for (int i = 0; i <= n + 1; i++) {
-        gamma = fELM(eta, gamma, k);
+	if (argc >= 4 && !parse_number(argv[3], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
 
-        if (i == n) {
-            constexpr double FACTOR = 1e10;
-            w1 = binary32(gamma * FACTOR);
-        } else if (i == n + 1) {
-            w2 = binary32(gamma);
-        }
-    }
+	if (argc >= 5 && !parse_number(argv[4], 0, 24, distinguished_bits)) {
+		std::cerr << "Please provide a number from 0 to 24, for the fourth argument." << std::endl;
+		return 0;
+	}
 
-    return std::rotl(w1, 17) ^ w2;
-}
+	std::unique_ptr<ProgressReporter> progress;
+	if (progress_options.enabled()) {
+		try {
+			progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
 
-// Collision Search
-void collision_search() {
-	std::unordered_map<uint32_t, uint32_t> output_input_map;
-	
-	// https://en.cppreference.com/w/cpp/numeric/random/mersenne_twister_engine.html
-	// https://en.cppreference.com/w/cpp/numeric/random/uniform_int_distribution.html
-	std::mt19937 rng(std::random_device{}());
-	std::uniform_int_distribution<uint32_t> dist;
-	
-	int counter = 0;
-	
-	while (true) {
-		uint32_t input = dist(rng);
-		uint32_t output = ELM(input);
-		
-		auto it = output_input_map.find(output);
-		
-		if (it != output_input_map.end() && it->second != input) {
-			std::cout << "Collision found! Input 1 = " << it->second 
-					  << " Input 2 = " << input << " Output = " << output << std::endl;
-			break;
-		} else {
-			output_input_map[output] = input;
+	if (argc >= 6) {
+		if (interpretations.size() != 1) {
+			std::cerr << "Please provide a single interpretation when using an ELM table, for the first argument." << std::endl;
+			return 0;
 		}
+		try {
+			const ELMTable table(argv[5]);
+			with_elm_interpretation(interpretations[0], [&]<typename I>(I) {
+				collision_search<I>(table.evaluator<I>(), collision_count, thread_count, static_cast<int>(distinguished_bits), progress.get());
+			});
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Please provide an ELM table of the given interpretation, for the fifth argument." << std::endl;
+		}
+		return 0;
 	}
-}
 
-	
-int main(int argc, char *argv[]) {
-	collision_search();
+	for (const int interpretation : interpretations) {
+		std::cout << "Interpretation " << interpretation_name(interpretation, false) << ":" << std::endl;
+		with_elm_interpretation(interpretation, [&]<typename I>(I) {
+			collision_search<I>(ComputedELM<I>{}, collision_count, thread_count, static_cast<int>(distinguished_bits), progress.get());
+		});
+	}
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "distinguished_points.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Collision search on the first digest_bits bits of the hortex digest. The walk maps a value x of digest_bits bits to
+// the message of message_bytes bytes whose first 8 bytes hold x in big-endian byte order (the others are 0) and
+// takes the first digest_bits bits of its digest, see distinguished_points.hpp.
+//
+// ./search_hortex_collisions <interpretation> <digest_bits> <message_bytes> <collisions> <threads> <distinguished_bits>
+
+// Distinguished points stored before the walk changes its salt, about 40 MiB
+constexpr uint64_t MAX_STORED_POINTS = uint64_t{1} << 20;
+
+// Calls of fFunction for one message of len bytes: one per absorbed block, including the block with the padding, and
+// two for squeezing
+inline uint64_t ffunction_calls(const std::size_t len) {
+	return (len + 7) / 8 + 2;
+}
+
+inline void write_message(const uint64_t x, std::vector<uint8_t> &message) {
+	for (int i = 0; i < 8; i++) {
+		message[i] = static_cast<uint8_t>(x >> (56 - 8 * i));
+	}
+}
+
+inline std::string to_hex(const uint8_t *bytes, const std::size_t len) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (std::size_t i = 0; i < len; i++) {
+		ss << std::setw(2) << static_cast<int>(bytes[i]);
+	}
+	return ss.str();
+}
+
+template<typename I>
+void collision_search(const int digest_bits, const std::size_t message_bytes, const uint64_t collision_count,
+					  const unsigned thread_count, const int distinguished_bits) {
+	// First digest_bits bits of the digest of the message of x
+	auto truncated_hortex = [&](const uint64_t x) {
+		thread_local std::vector<uint8_t> message;
+		message.assign(message_bytes, 0);
+		write_message(x, message);
+
+		uint8_t digest[Hortex<I>::digest_size];
+		hortex<I>(message.data(), message.size(), digest);
+
+		uint64_t prefix = 0;
+		for (int i = 0; i < 8; i++) {
+			prefix = prefix << 8 | digest[i];
+		}
+		return prefix >> (64 - digest_bits);
+	};
+
+	const uint64_t calls_per_message = ffunction_calls(message_bytes);
+
+	const WalkStatistics statistics = distinguished_point_search(
+		thread_count, digest_bits, distinguished_bits, MAX_STORED_POINTS, collision_count, truncated_hortex,
+		[&](const WalkCollision &collision, const double seconds) {
+			std::vector<uint8_t> message(message_bytes, 0);
+			uint8_t digest[Hortex<I>::digest_size];
+
+			std::cout << "Collision found after " << seconds << " s:" << std::endl;
+			for (const uint64_t x : {collision.a, collision.b}) {
+				write_message(x, message);
+				hortex<I>(message.data(), message.size(), digest);
+				std::cout << "  Message " << to_hex(message.data(), message.size()) << " Digest "
+						  << to_hex(digest, sizeof(digest)) << std::endl;
+			}
+		});
+
+	const double ffunction_total = static_cast<double>(statistics.steps) * static_cast<double>(calls_per_message);
+	// Expected number of evaluations until the first collision of a random function on 2^digest_bits values
+	const double birthday_bound = std::sqrt(std::numbers::pi / 2 * std::exp2(digest_bits));
+
+	std::cout << statistics.collisions << " collisions in " << statistics.seconds << " s, "
+			  << statistics.seconds / static_cast<double>(statistics.collisions) << " s per collision." << std::endl;
+	std::cout << statistics.steps << " hortex calls (" << static_cast<double>(statistics.steps) / static_cast<double>(statistics.collisions)
+			  << " per collision, birthday bound " << birthday_bound << " for the first collision)." << std::endl;
+	std::cout << ffunction_total << " fFunction calls (" << ffunction_total / static_cast<double>(statistics.collisions)
+			  << " per collision, " << ffunction_total / statistics.seconds << " per second)." << std::endl;
+	std::cout << statistics.distinguished_points << " distinguished points, " << statistics.repeated_collisions
+			  << " collisions found again, " << statistics.robin_hoods << " merges without collision, "
+			  << statistics.cycles << " trails ending in a cycle, " << statistics.abandoned_trails << " abandoned trails." << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	int interpretation = DefaultInterpretation::id;
+	unsigned long long digest_bits = 32;
+	unsigned long long message_bytes = 8;
+	unsigned long long collision_count = 1;
+	unsigned long long thread_count = default_thread_count();
+
+	if (argc >= 2 && !parse_interpretation(argv[1], interpretation)) {
+		std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx] (e.g. true,3,false), for the first argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 3 && !parse_number(argv[2], 16, 64, digest_bits)) {
+		std::cerr << "Please provide a number from 16 to 64, for the second argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 4 && !parse_number(argv[3], 8, 1 << 20, message_bytes)) {
+		std::cerr << "Please provide a number starting from 8, for the third argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 5 && !parse_number(argv[4], 1, 1ull << 32, collision_count)) {
+		std::cerr << "Please provide a number starting from 1, for the fourth argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 6 && !parse_number(argv[5], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the fifth argument." << std::endl;
+		return 0;
+	}
+
+	// A trail length of about 2^(digest_bits / 4) keeps the table small for every length
+	unsigned long long distinguished_bits = digest_bits / 4;
+	if (argc >= 7 && !parse_number(argv[6], 0, 32, distinguished_bits)) {
+		std::cerr << "Please provide a number from 0 to 32, for the sixth argument." << std::endl;
+		return 0;
+	}
+
+	std::cout << "Interpretation " << interpretation_name(interpretation) << ", " << digest_bits << "-bit digests of "
+			  << message_bytes << "-byte messages, " << ffunction_calls(message_bytes) << " fFunction calls per message." << std::endl;
+
+	with_interpretation(interpretation, [&]<typename I>(I) {
+		collision_search<I>(static_cast<int>(digest_bits), message_bytes, collision_count, thread_count,
+							static_cast<int>(distinguished_bits));
+	});
+	return 0;
+}
@@ -0,0 +1,369 @@
+#ifndef SLICE_HPP
+#define SLICE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "elm_batch.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Bijectivity test of a slice of the ELM inputs, given by a filter on each of the fields x_left (upper 12 bits, gamma
+// and thereby n), x_middle (16 bits, eta) and x_right (lower 4 bits, k). Only the inputs of the slice are evaluated,
+// and the collisions are found with a structure sized to the slice instead of the 512 MiB bitmap of the full sweep:
+//
+//   - Slices of up to SLICE_STORED_LIMIT inputs keep their outputs in input order. If the outputs span a range of at
+//     most 64 values per input, a dense bitmap over that range is scanned in input order. Otherwise every thread
+//     sorts its part of the (output, input) pairs and the sorted runs are merged; equal outputs are then adjacent.
+//   - Larger slices mark their outputs in an OutputBitmap like the full sweep.
+//
+// A slice of 2^20 inputs needs 4 MiB of outputs and 8 MiB of pairs and is tested in milliseconds.
+
+constexpr uint64_t SLICE_STORED_LIMIT = uint64_t{1} << 25;
+
+// Values v of one field with lo <= v <= hi and (v & mask) == value
+struct FieldFilter {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    uint32_t mask = 0;
+    uint32_t value = 0;
+
+    explicit FieldFilter(const uint32_t max = 0) : hi(max) {
+    }
+
+    bool matches(const uint32_t v) const {
+        return v >= lo && v <= hi && (v & mask) == value;
+    }
+
+    std::vector<uint32_t> values() const {
+        std::vector<uint32_t> result;
+        for (uint32_t v = lo; v <= hi; v++) {
+            if (matches(v)) {
+                result.push_back(v);
+            }
+        }
+        return result;
+    }
+};
+
+// Parses a field filter of a field with values up to max: "v", "lo-hi", "value/mask" or "lo-hi,value/mask". The
+// numbers are decimal or hexadecimal with 0x.
+inline bool parse_field_filter(const std::string &arg, const uint32_t max, FieldFilter &filter) {
+    auto parse = [max](const std::string &text, uint32_t &number) {
+        if (text.empty() || text[0] == '-' || text[0] == '+') {
+            return false;
+        }
+        char *end;
+        const unsigned long long parsed = std::strtoull(text.c_str(), &end, 0);
+        if (*end || parsed > max) {
+            return false;
+        }
+        number = static_cast<uint32_t>(parsed);
+        return true;
+    };
+
+    FieldFilter parsed(max);
+    std::string range = arg, masked;
+    const std::size_t comma = arg.find(',');
+    if (comma != std::string::npos) {
+        range = arg.substr(0, comma);
+        masked = arg.substr(comma + 1);
+    } else if (arg.find('/') != std::string::npos) {
+        range.clear();
+        masked = arg;
+    }
+
+    if (!range.empty()) {
+        const std::size_t dash = range.find('-');
+        if (dash == std::string::npos) {
+            if (!parse(range, parsed.lo)) {
+                return false;
+            }
+            parsed.hi = parsed.lo;
+        } else if (!parse(range.substr(0, dash), parsed.lo) || !parse(range.substr(dash + 1), parsed.hi) || parsed.lo > parsed.hi) {
+            return false;
+        }
+    }
+    if (!masked.empty()) {
+        const std::size_t slash = masked.find('/');
+        if (slash == std::string::npos || !parse(masked.substr(0, slash), parsed.value) || !parse(masked.substr(slash + 1), parsed.mask)
+            || (parsed.value & ~parsed.mask) != 0) {
+            return false;
+        }
+    }
+    filter = parsed;
+    return true;
+}
+
+// Inputs whose three fields all pass their filters, enumerated in ascending order. The field values are cached, so
+// enumerate() has to be called again after the filters are changed (take_slice_options does).
+class InputSlice {
+public:
+    FieldFilter x_left{0xFFF};
+    FieldFilter x_middle{0xFFFF};
+    FieldFilter x_right{0xF};
+
+    InputSlice() {
+        enumerate();
+    }
+
+    bool full() const {
+        return size() == ELM_DOMAIN_SIZE;
+    }
+
+    // Caches the values of the fields, after the filters are set
+    void enumerate() {
+        lefts = x_left.values();
+        middles = x_middle.values();
+        rights = x_right.values();
+    }
+
+    uint64_t size() const {
+        return uint64_t{lefts.size()} * middles.size() * rights.size();
+    }
+
+    // Input number index of the slice
+    uint32_t input(const uint64_t index) const {
+        const uint64_t low = index % (middles.size() * rights.size());
+        return lefts[index / (middles.size() * rights.size())] << 20 | middles[low / rights.size()] << 4 | rights[low % rights.size()];
+    }
+
+private:
+    std::vector<uint32_t> lefts, middles, rights;
+};
+
+// Removes the options --x-left, --x-middle and --x-right from argv like take_checkpoint_options. Returns false if a
+// filter cannot be parsed or no input passes all filters.
+inline bool take_slice_options(int &argc, char *argv[], InputSlice &slice) {
+    const struct {
+        std::string_view option;
+        FieldFilter *filter;
+        uint32_t max;
+    } fields[] = {{"--x-left", &slice.x_left, 0xFFF}, {"--x-middle", &slice.x_middle, 0xFFFF}, {"--x-right", &slice.x_right, 0xF}};
+
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        const auto field = std::find_if(std::begin(fields), std::end(fields), [&](const auto &f) { return f.option == argv[i]; });
+        if (field == std::end(fields)) {
+            argv[kept++] = argv[i];
+        } else if (i + 1 >= argc || !parse_field_filter(argv[++i], field->max, *field->filter)) {
+            return false;
+        }
+    }
+    argv[kept] = nullptr;
+    argc = kept;
+    slice.enumerate();
+    return slice.size() > 0;
+}
+
+// How slice_bijectivity found the collisions
+enum class SliceMethod {
+    DenseBitmap,
+    SortedRuns,
+    OutputBitmap
+};
+
+inline const char *slice_method_name(const SliceMethod method) {
+    switch (method) {
+        case SliceMethod::DenseBitmap:
+            return "dense bitmap";
+        case SliceMethod::SortedRuns:
+            return "merge of sorted runs";
+        default:
+            return "bitmap of all outputs";
+    }
+}
+
+struct SliceResult {
+    BijectivityResult result;
+    uint64_t inputs = 0;
+    SliceMethod method = SliceMethod::SortedRuns;
+    // Bytes of the collision structure
+    uint64_t memory = 0;
+};
+
+// Calls process(thread_index, first_index, count) concurrently for consecutive blocks of SWEEP_CHUNK_SIZE slice
+// indices until it returns false
+template<typename F>
+void sweep_slice_chunks(const unsigned thread_count, const uint64_t size, F &&process) {
+    std::atomic<uint64_t> next{0};
+    std::atomic<bool> stop{false};
+    auto worker = [&](const unsigned t) {
+        for (uint64_t first = next.fetch_add(SWEEP_CHUNK_SIZE); first < size && !stop.load(std::memory_order_relaxed);
+             first = next.fetch_add(SWEEP_CHUNK_SIZE)) {
+            if (!process(t, first, static_cast<uint32_t>(std::min<uint64_t>(SWEEP_CHUNK_SIZE, size - first)))) {
+                stop = true;
+            }
+        }
+    };
+
+    const unsigned threads = static_cast<unsigned>(std::min<uint64_t>(thread_count, (size + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE));
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+}
+
+// Bijectivity test of ELM<I> on the slice. With counting all collisions are counted, an input collides if a smaller
+// input of the slice has the same output. Without counting a colliding input is reported: the smallest one if the
+// outputs are stored, any one for larger slices. table is read instead of computing ELM if it is not null.
+template<typename I>
+SliceResult slice_bijectivity(const InputSlice &slice, const bool counting_activated, const unsigned thread_count,
+                              const uint32_t *table = nullptr) {
+    SliceResult slice_result;
+    slice_result.inputs = slice.size();
+    BijectivityResult &result = slice_result.result;
+
+    std::vector<std::vector<uint32_t>> inputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+    // Outputs of the count inputs from slice index first in outputs, or in the thread's buffer if outputs is null
+    auto evaluate = [&](const unsigned t, const uint64_t first, const uint32_t count, uint32_t *outputs) {
+        uint32_t *chunk_inputs = inputs[t].data();
+        for (uint32_t j = 0; j < count; j++) {
+            chunk_inputs[j] = slice.input(first + j);
+        }
+        if (table != nullptr) {
+            for (uint32_t j = 0; j < count; j++) {
+                outputs[j] = table[chunk_inputs[j]];
+            }
+        } else {
+            ELM_batch<I>(chunk_inputs, outputs, count);
+        }
+    };
+
+    if (slice_result.inputs > SLICE_STORED_LIMIT) {
+        slice_result.method = SliceMethod::OutputBitmap;
+        slice_result.memory = ELM_DOMAIN_SIZE / 8;
+        OutputBitmap seen;
+        std::vector<ThreadCounter> collisions(thread_count);
+        std::vector<std::vector<uint32_t>> outputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+        std::mutex result_mutex;
+
+        sweep_slice_chunks(thread_count, slice_result.inputs, [&](const unsigned t, const uint64_t first, const uint32_t count) {
+            evaluate(t, first, count, outputs[t].data());
+            for (uint32_t j = 0; j < count; j++) {
+                if (!seen.test_and_set(outputs[t][j])) {
+                    continue;
+                }
+                collisions[t].value++;
+                if (!counting_activated) {
+                    const std::lock_guard<std::mutex> lock(result_mutex);
+                    if (!result.collision_found) {
+                        result.collision_found = true;
+                        result.collision_input = inputs[t][j];
+                        result.collision_output = outputs[t][j];
+                    }
+                    return false;
+                }
+            }
+            return true;
+        });
+
+        for (const ThreadCounter &counter : collisions) {
+            result.collisions += counter.value;
+        }
+        result.collision_found = result.collision_found || result.collisions > 0;
+        return slice_result;
+    }
+
+    std::vector<uint32_t> outputs(slice_result.inputs);
+    sweep_slice_chunks(thread_count, slice_result.inputs, [&](const unsigned t, const uint64_t first, const uint32_t count) {
+        evaluate(t, first, count, outputs.data() + first);
+        return true;
+    });
+
+    // Smallest colliding slice index, slice_result.inputs if none, and its output as computed by the sweep
+    uint64_t first_collision = slice_result.inputs;
+    uint32_t first_collision_output = 0;
+    const auto [lowest, highest] = std::minmax_element(outputs.begin(), outputs.end());
+    const uint64_t range = uint64_t{*highest} - *lowest + 1;
+
+    if (range <= 64 * slice_result.inputs) {
+        slice_result.method = SliceMethod::DenseBitmap;
+        slice_result.memory = (range + 63) / 64 * 8;
+        std::vector<uint64_t> seen((range + 63) / 64);
+        const uint32_t offset = *lowest;
+        for (uint64_t i = 0; i < slice_result.inputs; i++) {
+            const uint32_t bit = outputs[i] - offset;
+            const uint64_t mask = uint64_t{1} << (bit & 63);
+            if ((seen[bit >> 6] & mask) != 0) {
+                result.collisions++;
+                if (i < first_collision) {
+                    first_collision = i;
+                    first_collision_output = outputs[i];
+                }
+                if (!counting_activated) {
+                    break;
+                }
+            }
+            seen[bit >> 6] |= mask;
+        }
+    } else {
+        slice_result.method = SliceMethod::SortedRuns;
+        slice_result.memory = slice_result.inputs * sizeof(uint64_t);
+        // Output in the upper and slice index in the lower half, so equal outputs are ordered by input
+        std::vector<uint64_t> pairs(slice_result.inputs);
+        const unsigned runs = static_cast<unsigned>(std::clamp<uint64_t>(thread_count, 1, (slice_result.inputs + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE));
+        std::vector<uint64_t> bounds(runs + 1);
+        for (unsigned r = 0; r <= runs; r++) {
+            bounds[r] = slice_result.inputs * r / runs;
+        }
+
+        parallel_ranges(runs, runs, [&](unsigned, const uint64_t begin, const uint64_t end) {
+            for (uint64_t r = begin; r < end; r++) {
+                for (uint64_t i = bounds[r]; i < bounds[r + 1]; i++) {
+                    pairs[i] = uint64_t{outputs[i]} << 32 | i;
+                }
+                std::sort(pairs.begin() + bounds[r], pairs.begin() + bounds[r + 1]);
+            }
+        });
+        std::vector<uint32_t>().swap(outputs);
+
+        // Pairwise merges of neighbouring runs, the merges of one round in parallel
+        for (unsigned width = 1; width < runs; width *= 2) {
+            std::vector<std::thread> merges;
+            for (unsigned r = 0; r + width < runs; r += 2 * width) {
+                merges.emplace_back([&, r, width] {
+                    std::inplace_merge(pairs.begin() + bounds[r], pairs.begin() + bounds[r + width],
+                                       pairs.begin() + bounds[std::min(runs, r + 2 * width)]);
+                });
+            }
+            for (std::thread &merge : merges) {
+                merge.join();
+            }
+        }
+
+        for (uint64_t i = 1; i < pairs.size(); i++) {
+            if (pairs[i] >> 32 == pairs[i - 1] >> 32) {
+                result.collisions++;
+                if ((pairs[i] & 0xFFFFFFFF) < first_collision) {
+                    first_collision = pairs[i] & 0xFFFFFFFF;
+                    first_collision_output = static_cast<uint32_t>(pairs[i] >> 32);
+                }
+            }
+        }
+        if (!counting_activated) {
+            result.collisions = std::min<uint64_t>(result.collisions, 1);
+        }
+    }
+
+    if (first_collision < slice_result.inputs) {
+        result.collision_found = true;
+        result.collision_input = slice.input(first_collision);
+        result.collision_output = first_collision_output;
+    }
+    return slice_result;
+}
+
+#endif
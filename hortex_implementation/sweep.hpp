@@ -0,0 +1,937 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "elm_batch.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+
+// Exhaustive sweeps over the 2^32 ELM inputs, shared by bijectivity_test.cpp, fused_bijectivity_test.cpp and
+// attack_different_interpretations.cpp.
+
+constexpr uint64_t ELM_DOMAIN_SIZE = 4294967296;
+
+// Number of inputs a worker takes from the shared cursor at once, also the batch size of ELM_batch
+constexpr uint32_t SWEEP_CHUNK_SIZE = 4096;
+
+inline unsigned default_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Words of one region of an OutputBitmap (4 MiB), the unit in which checkpoints write bitmaps
+constexpr uint64_t OUTPUT_BITMAP_REGION_WORDS = uint64_t{1} << 19;
+
+// Bitstring of length 2^32 stored in 2^26 words of 64 bits (512 MiB) that all threads update atomically. Every region
+// remembers whether a bit in it was set since the last take_dirty, so checkpoints only write the regions that changed.
+class OutputBitmap {
+public:
+    static constexpr uint64_t region_count = ELM_DOMAIN_SIZE / 64 / OUTPUT_BITMAP_REGION_WORDS;
+
+    OutputBitmap() : words(ELM_DOMAIN_SIZE / 64), dirty(region_count) {
+    }
+
+    // Sets the bit of y and returns whether it was already set
+    bool test_and_set(const uint32_t y) {
+        const uint64_t mask = uint64_t{1} << (y & 63);
+        if ((words[y >> 6].fetch_or(mask, std::memory_order_relaxed) & mask) != 0) {
+            return true;
+        }
+
+        // Loading first keeps the flag's cache line shared while the region stays dirty
+        std::atomic<bool> &region_dirty = dirty[(y >> 6) / OUTPUT_BITMAP_REGION_WORDS];
+        if (!region_dirty.load(std::memory_order_relaxed)) {
+            region_dirty.store(true, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    bool test(const uint32_t y) const {
+        return (words[y >> 6].load(std::memory_order_relaxed) >> (y & 63) & 1) != 0;
+    }
+
+    // Returns whether a bit of the region was set since the last call and clears the flag
+    bool take_dirty(const uint64_t region) {
+        return dirty[region].exchange(false, std::memory_order_relaxed);
+    }
+
+    // Copies the region to or from OUTPUT_BITMAP_REGION_WORDS words, only while no thread sets bits
+    void load_region(const uint64_t region, uint64_t *destination) const {
+        for (uint64_t i = 0; i < OUTPUT_BITMAP_REGION_WORDS; i++) {
+            destination[i] = words[region * OUTPUT_BITMAP_REGION_WORDS + i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void store_region(const uint64_t region, const uint64_t *source) {
+        for (uint64_t i = 0; i < OUTPUT_BITMAP_REGION_WORDS; i++) {
+            words[region * OUTPUT_BITMAP_REGION_WORDS + i].store(source[i], std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> words;
+    std::vector<std::atomic<bool>> dirty;
+};
+
+// Per-thread accumulator on its own cache line
+struct alignas(64) ThreadCounter {
+    uint64_t value = 0;
+};
+
+// Inputs with the same x_left (the upper 12 bits), which share gamma and thereby the iteration count n of ELM
+constexpr uint64_t X_LEFT_BUCKET_SIZE = uint64_t{1} << 20;
+constexpr uint64_t X_LEFT_BUCKET_COUNT = ELM_DOMAIN_SIZE / X_LEFT_BUCKET_SIZE;
+
+// A chunk never spans two x_left buckets, so every SIMD batch of a chunk runs the same n + 2 iterations in all lanes
+static_assert(X_LEFT_BUCKET_SIZE % SWEEP_CHUNK_SIZE == 0, "chunks lie within one x_left bucket");
+
+// Order in which a sweep hands out its chunks. ELM runs n + 2 iterations with n = floor(6 * gamma), and gamma grows
+// with x_left in every constants setting, so an input with a large x_left costs up to 4 times as much as one with a
+// small x_left.
+enum class SweepOrder {
+    // Ascending inputs, so that a sweep on one thread meets the collisions in input order
+    Ascending,
+    // The x_left buckets from the largest n down, the chunks of a bucket in ascending order. The threads end with the
+    // cheapest chunks and finish at nearly the same time (longest processing time first).
+    CostDescending
+};
+
+// Chunks of a sweep in the order they are handed out: every stride-th chunk of the domain, arranged by order. The
+// position in this sequence is the cursor that the threads share, taking the next chunk whenever they are done with
+// one, so faster threads simply take more chunks.
+class SweepSchedule {
+public:
+    explicit SweepSchedule(const SweepOrder order = SweepOrder::Ascending, const uint64_t chunk_stride = 1)
+        : descending(order == SweepOrder::CostDescending), stride(chunk_stride) {
+        const uint64_t bucket_chunks = X_LEFT_BUCKET_SIZE / SWEEP_CHUNK_SIZE;
+        if (descending && stride != 1) {
+            for (uint64_t bucket = X_LEFT_BUCKET_COUNT; bucket-- > 0;) {
+                for (uint64_t chunk = bucket * bucket_chunks; chunk < (bucket + 1) * bucket_chunks; chunk++) {
+                    if (chunk % stride == 0) {
+                        chunks.push_back(static_cast<uint32_t>(chunk));
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t size() const {
+        return (ELM_DOMAIN_SIZE / SWEEP_CHUNK_SIZE + stride - 1) / stride;
+    }
+
+    // First input of the chunk at position
+    uint64_t chunk_start(const uint64_t position) const {
+        if (!descending) {
+            return position * stride * SWEEP_CHUNK_SIZE;
+        }
+        if (stride != 1) {
+            return uint64_t{chunks[position]} * SWEEP_CHUNK_SIZE;
+        }
+        const uint64_t bucket_chunks = X_LEFT_BUCKET_SIZE / SWEEP_CHUNK_SIZE;
+        const uint64_t bucket = X_LEFT_BUCKET_COUNT - 1 - position / bucket_chunks;
+        return bucket * X_LEFT_BUCKET_SIZE + position % bucket_chunks * SWEEP_CHUNK_SIZE;
+    }
+
+private:
+    bool descending;
+    uint64_t stride;
+    // Chunk indices of a descending schedule with a stride
+    std::vector<uint32_t> chunks;
+};
+
+// Pausing of a sweep for checkpoints. The sweep starts at the schedule position first_chunk. When due() returns true,
+// every thread finishes its chunk and the last one calls save(next_chunk) while the others wait: then all chunks
+// before the position next_chunk are processed and no later chunk has been started.
+struct SweepPause {
+    uint64_t first_chunk = 0;
+    std::function<bool()> due;
+    std::function<void(uint64_t next_chunk)> save;
+};
+
+// Calls process_chunk(thread_index, chunk_start) concurrently on thread_count threads for every chunk of
+// SWEEP_CHUNK_SIZE inputs of schedule, taken from a shared cursor, until process_chunk returns false. pause may be
+// null.
+template<typename F>
+void sweep_chunks(const unsigned thread_count, const SweepSchedule &schedule, F &&process_chunk, const SweepPause *pause) {
+    std::atomic<uint64_t> next_chunk{pause != nullptr ? pause->first_chunk : 0};
+    std::atomic<bool> stop{false};
+
+    std::atomic<bool> pausing{false};
+    std::mutex pause_mutex;
+    std::condition_variable resumed;
+    unsigned active = thread_count, waiting = 0;
+    uint64_t generation = 0;
+
+    // Called with pause_mutex held once all active threads wait
+    auto save = [&] {
+        pause->save(next_chunk.load(std::memory_order_relaxed));
+        pausing.store(false, std::memory_order_relaxed);
+        waiting = 0;
+        generation++;
+        resumed.notify_all();
+    };
+
+    auto wait_for_pause = [&] {
+        std::unique_lock<std::mutex> lock(pause_mutex);
+        if (!pausing.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (++waiting == active) {
+            save();
+            return;
+        }
+        const uint64_t current = generation;
+        resumed.wait(lock, [&] { return generation != current; });
+    };
+
+    auto worker = [&](const unsigned thread_index) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            if (pause != nullptr) {
+                // Only the first thread asks for a pause, so due() is never called concurrently
+                if (thread_index == 0 && !pausing.load(std::memory_order_relaxed) && pause->due()) {
+                    pausing.store(true, std::memory_order_relaxed);
+                }
+                if (pausing.load(std::memory_order_relaxed)) {
+                    wait_for_pause();
+                    continue;
+                }
+            }
+
+            const uint64_t position = next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (position >= schedule.size()) {
+                break;
+            }
+            if (!process_chunk(thread_index, schedule.chunk_start(position))) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        if (pause != nullptr) {
+            // A pause that only waited for this thread takes place now
+            const std::lock_guard<std::mutex> lock(pause_mutex);
+            if (--active > 0 && pausing.load(std::memory_order_relaxed) && waiting == active) {
+                save();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+// Evaluates ELM<I> on all 2^32 inputs with thread_count threads. The threads take chunks of SWEEP_CHUNK_SIZE inputs
+// from a shared cursor and call process(thread_index, inputs, outputs, count) for every chunk. process is called
+// concurrently and returns false to stop all threads. With one thread the chunks are processed in schedule order.
+// If table is not null, it holds the outputs of ELM<I> (see elm_table.hpp) and outputs points into it. pause is
+// passed on to sweep_chunks, order to its schedule.
+template<typename I, typename F>
+void sweep_elm(const unsigned thread_count, F &&process, const uint32_t *table = nullptr,
+               const SweepPause *pause = nullptr, const SweepOrder order = SweepOrder::Ascending) {
+    std::vector<std::vector<uint32_t>> inputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+    std::vector<std::vector<uint32_t>> outputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+
+    sweep_chunks(thread_count, SweepSchedule(order), [&](const unsigned thread_index, const uint64_t chunk_start) {
+        uint32_t *chunk_inputs = inputs[thread_index].data();
+        for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+            chunk_inputs[j] = static_cast<uint32_t>(chunk_start + j);
+        }
+        const uint32_t *chunk_outputs = table != nullptr ? table + chunk_start : outputs[thread_index].data();
+        if (table == nullptr) {
+            ELM_batch<I>(chunk_inputs, outputs[thread_index].data(), SWEEP_CHUNK_SIZE);
+        }
+
+        return process(thread_index, static_cast<const uint32_t *>(chunk_inputs), chunk_outputs, SWEEP_CHUNK_SIZE);
+    }, pause);
+}
+
+// ELM does not depend on use_pseudocode_arx, so the 32 interpretations have 16 ELM variants. The fused sweeps
+// select them by a bit mask of elm_variant(id).
+constexpr int ELM_VARIANT_COUNT = 16;
+
+constexpr int elm_variant(const int id) {
+    return id >> 1;
+}
+
+constexpr int elm_variant_interpretation(const int variant) {
+    return variant << 1 | 1;
+}
+
+struct BijectivityResult {
+    // Number of inputs whose output was already produced by another input, i.e. 2^32 minus the size of the image
+    uint64_t collisions = 0;
+
+    // Only set without counting: one input colliding with another input
+    bool collision_found = false;
+    uint32_t collision_input = 0;
+    uint32_t collision_output = 0;
+};
+
+// Checkpoints of the bijectivity sweeps, implemented by SweepCheckpoint (checkpoint.hpp). results and bitmaps have one
+// entry per ELM variant and bitmaps[v] is null for the variants that are not swept. restore fills them before the
+// sweep and returns the chunk to continue from, due and save are used as in SweepPause.
+struct BijectivityCheckpoint {
+    std::function<uint64_t(std::vector<BijectivityResult> &results, const std::vector<OutputBitmap *> &bitmaps)> restore;
+    std::function<bool()> due;
+    std::function<void(uint64_t next_chunk, const std::vector<BijectivityResult> &results,
+                       const std::vector<OutputBitmap *> &bitmaps)> save;
+};
+
+// results with the collisions counted by the threads added, ELM_VARIANT_COUNT counters per thread
+inline std::vector<BijectivityResult> add_thread_collisions(std::vector<BijectivityResult> results,
+                                                            const std::vector<ThreadCounter> &collisions) {
+    for (std::size_t i = 0; i < collisions.size(); i++) {
+        results[i % ELM_VARIANT_COUNT].collisions += collisions[i].value;
+    }
+    return results;
+}
+
+// SweepPause that restores results and bitmaps from checkpoint and saves them together with the collisions counted
+// so far
+inline SweepPause bijectivity_pause(const BijectivityCheckpoint &checkpoint, std::vector<BijectivityResult> &results,
+                                    const std::vector<OutputBitmap *> &bitmaps,
+                                    const std::vector<ThreadCounter> &collisions) {
+    SweepPause pause;
+    pause.first_chunk = checkpoint.restore(results, bitmaps);
+    pause.due = checkpoint.due;
+    pause.save = [&checkpoint, &results, &bitmaps, &collisions](const uint64_t next_chunk) {
+        checkpoint.save(next_chunk, add_thread_collisions(results, collisions), bitmaps);
+    };
+    return pause;
+}
+
+// Bijectivity test of ELM<I> on thread_count threads. Every input whose output bit was already set counts as one
+// collision, so the count does not depend on the thread count. Without counting, the first thread that finds a
+// collision stops all others. With one thread the reported input is the first one that collides with a smaller input.
+// A counting sweep visits all inputs and takes the chunks in SweepOrder::CostDescending, a sweep without counting in
+// ascending order. table is passed on to sweep_elm. With a checkpoint the sweep continues from the last saved state and saves it
+// whenever it is due. progress reports the sweep if it is not null.
+template<typename I>
+BijectivityResult bijectivity_sweep(const bool counting_activated, const unsigned thread_count,
+                                    const uint32_t *table = nullptr, const BijectivityCheckpoint *checkpoint = nullptr,
+                                    ProgressReporter *progress = nullptr) {
+    constexpr int variant = elm_variant(I::id);
+
+    OutputBitmap seen;
+    std::vector<OutputBitmap *> bitmaps(ELM_VARIANT_COUNT, nullptr);
+    bitmaps[variant] = &seen;
+    std::vector<ThreadCounter> collisions(thread_count * ELM_VARIANT_COUNT);
+
+    std::mutex result_mutex;
+    std::vector<BijectivityResult> results(ELM_VARIANT_COUNT);
+    BijectivityResult &result = results[variant];
+
+    SweepPause pause;
+    if (checkpoint != nullptr) {
+        pause = bijectivity_pause(*checkpoint, results, bitmaps, collisions);
+        if (result.collision_found) {
+            return result;
+        }
+    }
+
+    ProgressRun run(progress, {"Bijectivity sweep", thread_count, ELM_DOMAIN_SIZE, 0,
+                               pause.first_chunk * SWEEP_CHUNK_SIZE, result.collisions});
+
+    sweep_elm<I>(thread_count, [&](const unsigned thread_index, const uint32_t *inputs, const uint32_t *outputs,
+                                   const uint32_t count) {
+        uint64_t &thread_collisions = collisions[thread_index * ELM_VARIANT_COUNT + variant].value;
+        const uint64_t previous_collisions = thread_collisions;
+
+        for (uint32_t j = 0; j < count; j++) {
+            if (!seen.test_and_set(outputs[j])) {
+                continue;
+            }
+
+            if (!counting_activated) {
+                run.add(thread_index, j + 1, j + 1, 1);
+                const std::lock_guard<std::mutex> lock(result_mutex);
+                if (!result.collision_found) {
+                    result.collision_found = true;
+                    result.collision_input = inputs[j];
+                    result.collision_output = outputs[j];
+                }
+                return false;
+            }
+
+            thread_collisions++;
+        }
+        run.add(thread_index, count, count, thread_collisions - previous_collisions);
+        return true;
+    }, table, checkpoint != nullptr ? &pause : nullptr, counting_activated ? SweepOrder::CostDescending : SweepOrder::Ascending);
+
+    return add_thread_collisions(results, collisions)[variant];
+}
+
+template<int CS>
+void fused_constants_setting_batch(const uint32_t *in, uint32_t *const outputs[ELM_VARIANT_COUNT], const std::size_t count) {
+    uint32_t *const out[4] = {outputs[CS << 1], outputs[CS << 1 | 1], outputs[8 | CS << 1], outputs[8 | CS << 1 | 1]};
+    if (out[0] != nullptr || out[1] != nullptr || out[2] != nullptr || out[3] != nullptr) {
+        ELM_fused_batch<CS>(in, out, count, detected_backend());
+    }
+}
+
+// outputs[v][i] = ELM of variant v for all variants whose outputs are not null, with one ELM_fused_batch per
+// constants setting
+inline void fused_variants_batch(const uint32_t *in, uint32_t *const outputs[ELM_VARIANT_COUNT], const std::size_t count) {
+    fused_constants_setting_batch<0>(in, outputs, count);
+    fused_constants_setting_batch<1>(in, outputs, count);
+    fused_constants_setting_batch<2>(in, outputs, count);
+    fused_constants_setting_batch<3>(in, outputs, count);
+}
+
+// Like sweep_elm for the ELM variants in the bit mask variants, evaluated together for every chunk of inputs.
+// process(thread_index, inputs, outputs, count) gets outputs[v] for every selected variant v and null for the others.
+// Variants that are removed from the mask during the sweep are not computed any more.
+template<typename F>
+void sweep_elm_fused(const unsigned thread_count, std::atomic<uint32_t> &variants, F &&process,
+                     const SweepPause *pause = nullptr, const SweepOrder order = SweepOrder::Ascending) {
+    std::vector<std::vector<uint32_t>> inputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+    std::vector<std::vector<uint32_t>> buffers(thread_count, std::vector<uint32_t>(ELM_VARIANT_COUNT * SWEEP_CHUNK_SIZE));
+
+    sweep_chunks(thread_count, SweepSchedule(order), [&](const unsigned thread_index, const uint64_t chunk_start) {
+        const uint32_t mask = variants.load(std::memory_order_relaxed);
+        if (mask == 0) {
+            return false;
+        }
+
+        uint32_t *chunk_inputs = inputs[thread_index].data();
+        for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+            chunk_inputs[j] = static_cast<uint32_t>(chunk_start + j);
+        }
+        uint32_t *outputs[ELM_VARIANT_COUNT];
+        for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+            outputs[v] = (mask >> v & 1) != 0 ? buffers[thread_index].data() + v * SWEEP_CHUNK_SIZE : nullptr;
+        }
+        fused_variants_batch(chunk_inputs, outputs, SWEEP_CHUNK_SIZE);
+
+        return process(thread_index, static_cast<const uint32_t *>(chunk_inputs),
+                       static_cast<const uint32_t *const *>(outputs), SWEEP_CHUNK_SIZE);
+    }, pause);
+}
+
+// Bijectivity test of the ELM variants in the bit mask variant_mask in one pass over the inputs, with one bitmap
+// (512 MiB) per variant. results[v] equals bijectivity_sweep of variant v. Without counting, a variant leaves the
+// sweep once it has a collision and the sweep ends when all variants have one. checkpoint and progress are used as
+// in bijectivity_sweep, the progress counts every input once and the ELM calls of all variants.
+inline std::vector<BijectivityResult> fused_bijectivity_sweep(const uint32_t variant_mask, const bool counting_activated,
+                                                              const unsigned thread_count,
+                                                              const BijectivityCheckpoint *checkpoint = nullptr,
+                                                              ProgressReporter *progress = nullptr) {
+    std::vector<std::unique_ptr<OutputBitmap>> seen(ELM_VARIANT_COUNT);
+    std::vector<OutputBitmap *> bitmaps(ELM_VARIANT_COUNT, nullptr);
+    for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+        if ((variant_mask >> v & 1) != 0) {
+            seen[v] = std::make_unique<OutputBitmap>();
+            bitmaps[v] = seen[v].get();
+        }
+    }
+    std::vector<ThreadCounter> collisions(thread_count * ELM_VARIANT_COUNT);
+
+    std::mutex result_mutex;
+    std::vector<BijectivityResult> results(ELM_VARIANT_COUNT);
+
+    SweepPause pause;
+    if (checkpoint != nullptr) {
+        pause = bijectivity_pause(*checkpoint, results, bitmaps, collisions);
+    }
+
+    uint32_t remaining = variant_mask;
+    for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+        if (results[v].collision_found) {
+            remaining &= ~(uint32_t{1} << v);
+        }
+    }
+    std::atomic<uint32_t> variants{remaining};
+
+    uint64_t restored_collisions = 0;
+    for (const BijectivityResult &result : results) {
+        restored_collisions += result.collisions;
+    }
+    ProgressRun run(progress, {"Fused bijectivity sweep", thread_count, ELM_DOMAIN_SIZE, 0,
+                               pause.first_chunk * SWEEP_CHUNK_SIZE, restored_collisions});
+
+    sweep_elm_fused(thread_count, variants, [&](const unsigned thread_index, const uint32_t *inputs,
+                                                const uint32_t *const *outputs, const uint32_t count) {
+        uint64_t elm_calls = 0, found_collisions = 0;
+        for (int v = 0; v < ELM_VARIANT_COUNT; v++) {
+            if (outputs[v] == nullptr) {
+                continue;
+            }
+            elm_calls += count;
+
+            for (uint32_t j = 0; j < count; j++) {
+                if (!seen[v]->test_and_set(outputs[v][j])) {
+                    continue;
+                }
+
+                if (!counting_activated) {
+                    const std::lock_guard<std::mutex> lock(result_mutex);
+                    if (!results[v].collision_found) {
+                        results[v].collision_found = true;
+                        results[v].collision_input = inputs[j];
+                        results[v].collision_output = outputs[v][j];
+                        variants.fetch_and(~(uint32_t{1} << v), std::memory_order_relaxed);
+                    }
+                    found_collisions++;
+                    break;
+                }
+
+                collisions[thread_index * ELM_VARIANT_COUNT + v].value++;
+                found_collisions++;
+            }
+        }
+        run.add(thread_index, count, elm_calls, found_collisions);
+        return true;
+    }, checkpoint != nullptr ? &pause : nullptr, counting_activated ? SweepOrder::CostDescending : SweepOrder::Ascending);
+
+    return add_thread_collisions(results, collisions);
+}
+
+// Splits [0, total) into one contiguous range per thread and calls f(thread_index, begin, end) concurrently
+template<typename F>
+void parallel_ranges(const unsigned thread_count, const uint64_t total, F &&f) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < thread_count; t++) {
+        threads.emplace_back(f, t, total * t / thread_count, total * (t + 1) / thread_count);
+    }
+    f(0u, uint64_t{0}, total / thread_count);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+// One saturating counter of Bits bits (2 or 4) per output, packed into 64-bit words that are updated with
+// compare-and-swap. 2^32 counters need 1 GiB with 2 bits and 2 GiB with 4 bits.
+template<int Bits>
+class SaturatingCounters {
+public:
+    static_assert(Bits == 2 || Bits == 4, "counters have 2 or 4 bits");
+
+    static constexpr int counters_per_word = 64 / Bits;
+    static constexpr unsigned max_value = (1u << Bits) - 1;
+
+    SaturatingCounters() : words(ELM_DOMAIN_SIZE / counters_per_word) {
+    }
+
+    void increment(const uint32_t y) {
+        std::atomic<uint64_t> &word = words[y / counters_per_word];
+        const int shift = y % counters_per_word * Bits;
+
+        uint64_t old = word.load(std::memory_order_relaxed);
+        while ((old >> shift & max_value) != max_value &&
+               !word.compare_exchange_weak(old, old + (uint64_t{1} << shift), std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t word_count() const {
+        return words.size();
+    }
+
+    // Bit c * Bits of the result is set for every saturated counter c of a word
+    static uint64_t saturated_bits(const uint64_t word) {
+        uint64_t all = word;
+        for (int b = 1; b < Bits; b++) {
+            all &= word >> b;
+        }
+        return all & ~uint64_t{0} / max_value;
+    }
+
+    // Counters of the outputs word_index * counters_per_word, ... in the lowest bits first
+    uint64_t word(const uint64_t word_index) const {
+        return words[word_index].load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> words;
+};
+
+struct PreimageHistogram {
+    // outputs[m] is the number of outputs with exactly m preimages. The last entry counts all outputs whose counter
+    // saturated, i.e. that have at least outputs.size() - 1 preimages.
+    std::vector<uint64_t> outputs;
+
+    // Outputs with the most preimages and their exact number of preimages, sorted descending
+    std::vector<std::pair<uint32_t, uint64_t>> top_outputs;
+};
+
+// Preimage counts per output, ordered by more preimages first and the smaller output on ties
+inline bool more_preimages(const std::pair<uint32_t, uint64_t> &a, const std::pair<uint32_t, uint64_t> &b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+}
+
+// The top_count outputs with the most preimages among the saturated_count outputs whose counter saturated, with their
+// exact preimage counts from a second sweep. The saturated outputs are numbered in ascending order, from a rank per
+// block of 8 counter words and the saturated counters before them in the block, so their counts fit into one array.
+template<typename I, int Bits>
+std::vector<std::pair<uint32_t, uint64_t>> top_saturated_outputs(const SaturatingCounters<Bits> &counters,
+                                                                 const uint64_t saturated_count, const unsigned thread_count,
+                                                                 const std::size_t top_count, const uint32_t *table) {
+    using Counters = SaturatingCounters<Bits>;
+    constexpr uint64_t block_words = 8;
+    const uint64_t block_count = counters.word_count() / block_words;
+
+    // Saturated outputs before block b
+    std::vector<uint32_t> block_rank(block_count + 1, 0);
+    parallel_ranges(thread_count, block_count, [&](unsigned, const uint64_t begin, const uint64_t end) {
+        for (uint64_t b = begin; b < end; b++) {
+            uint32_t saturated = 0;
+            for (uint64_t w = b * block_words; w < (b + 1) * block_words; w++) {
+                saturated += static_cast<uint32_t>(std::popcount(Counters::saturated_bits(counters.word(w))));
+            }
+            block_rank[b + 1] = saturated;
+        }
+    });
+    for (uint64_t b = 0; b < block_count; b++) {
+        block_rank[b + 1] += block_rank[b];
+    }
+
+    std::vector<std::atomic<uint32_t>> exact(saturated_count);
+    sweep_elm<I>(thread_count, [&](unsigned, const uint32_t *, const uint32_t *outputs, const uint32_t count) {
+        for (uint32_t j = 0; j < count; j++) {
+            const uint64_t w = outputs[j] / Counters::counters_per_word;
+            const int shift = outputs[j] % Counters::counters_per_word * Bits;
+            const uint64_t bits = Counters::saturated_bits(counters.word(w));
+            if ((bits >> shift & 1) == 0) {
+                continue;
+            }
+            uint64_t rank = block_rank[w / block_words] + std::popcount(bits & ((uint64_t{1} << shift) - 1));
+            for (uint64_t v = w - w % block_words; v < w; v++) {
+                rank += std::popcount(Counters::saturated_bits(counters.word(v)));
+            }
+            exact[rank].fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }, table);
+
+    // Every thread keeps its best top_count outputs in a heap whose front is the weakest of them
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> thread_tops(thread_count);
+    parallel_ranges(thread_count, block_count, [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        std::vector<std::pair<uint32_t, uint64_t>> &top = thread_tops[t];
+        for (uint64_t b = begin; b < end; b++) {
+            uint64_t rank = block_rank[b];
+            for (uint64_t w = b * block_words; w < (b + 1) * block_words; w++) {
+                for (uint64_t bits = Counters::saturated_bits(counters.word(w)); bits != 0; bits &= bits - 1) {
+                    const std::pair<uint32_t, uint64_t> candidate{
+                        static_cast<uint32_t>(w * Counters::counters_per_word + std::countr_zero(bits) / Bits),
+                        exact[rank++].load(std::memory_order_relaxed)};
+                    if (top.size() < top_count) {
+                        top.push_back(candidate);
+                        std::push_heap(top.begin(), top.end(), more_preimages);
+                    } else if (more_preimages(candidate, top.front())) {
+                        std::pop_heap(top.begin(), top.end(), more_preimages);
+                        top.back() = candidate;
+                        std::push_heap(top.begin(), top.end(), more_preimages);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<std::pair<uint32_t, uint64_t>> top;
+    for (const auto &thread_top : thread_tops) {
+        top.insert(top.end(), thread_top.begin(), thread_top.end());
+    }
+    std::sort(top.begin(), top.end(), more_preimages);
+    if (top.size() > top_count) {
+        top.resize(top_count);
+    }
+    return top;
+}
+
+// Counts the preimages of every output of ELM<I> over all 2^32 inputs. If top_count is not 0, the top_count outputs
+// with the most preimages are collected, the smaller output first on ties. Their exact preimage counts are determined
+// by a second sweep if their counters saturated; if more than top_count counters saturated, all saturated outputs are
+// counted exactly (top_saturated_outputs). table is passed on to sweep_elm.
+template<typename I, int Bits>
+PreimageHistogram preimage_histogram_sweep(const unsigned thread_count, const std::size_t top_count,
+                                           const uint32_t *table = nullptr) {
+    using Counters = SaturatingCounters<Bits>;
+    constexpr unsigned max_value = Counters::max_value;
+
+    Counters counters;
+
+    sweep_elm<I>(thread_count, [&](unsigned, const uint32_t *, const uint32_t *outputs, const uint32_t count) {
+        for (uint32_t j = 0; j < count; j++) {
+            counters.increment(outputs[j]);
+        }
+        return true;
+    }, table);
+
+    std::vector<std::vector<uint64_t>> thread_histograms(thread_count, std::vector<uint64_t>(max_value + 1));
+
+    parallel_ranges(thread_count, counters.word_count(), [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        std::vector<uint64_t> &histogram = thread_histograms[t];
+        for (uint64_t w = begin; w < end; w++) {
+            const uint64_t word = counters.word(w);
+            for (int c = 0; c < Counters::counters_per_word; c++) {
+                histogram[word >> (c * Bits) & max_value]++;
+            }
+        }
+    });
+
+    PreimageHistogram result;
+    result.outputs.assign(max_value + 1, 0);
+    for (const std::vector<uint64_t> &histogram : thread_histograms) {
+        for (unsigned m = 0; m <= max_value; m++) {
+            result.outputs[m] += histogram[m];
+        }
+    }
+
+    if (top_count == 0) {
+        return result;
+    }
+
+    if (result.outputs[max_value] > top_count) {
+        result.top_outputs = top_saturated_outputs<I, Bits>(counters, result.outputs[max_value], thread_count, top_count, table);
+        return result;
+    }
+
+    // Smallest preimage count such that at most top_count outputs have at least as many preimages
+    unsigned threshold = max_value;
+    uint64_t at_least = result.outputs[max_value];
+    while (threshold > 2 && at_least + result.outputs[threshold - 1] <= top_count) {
+        threshold--;
+        at_least += result.outputs[threshold];
+    }
+
+    // All outputs with at least threshold preimages are taken, the remaining places go to the smallest outputs with
+    // threshold - 1 preimages. The ranges of the threads are in ascending order.
+    const std::size_t remaining = top_count - at_least;
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> thread_candidates(thread_count), thread_fills(thread_count);
+
+    parallel_ranges(thread_count, counters.word_count(), [&](const unsigned t, const uint64_t begin, const uint64_t end) {
+        for (uint64_t w = begin; w < end; w++) {
+            const uint64_t word = counters.word(w);
+            for (int c = 0; c < Counters::counters_per_word; c++) {
+                const unsigned value = word >> (c * Bits) & max_value;
+                if (value >= threshold) {
+                    thread_candidates[t].emplace_back(static_cast<uint32_t>(w * Counters::counters_per_word + c), value);
+                } else if (value == threshold - 1 && thread_fills[t].size() < remaining) {
+                    thread_fills[t].emplace_back(static_cast<uint32_t>(w * Counters::counters_per_word + c), value);
+                }
+            }
+        }
+    });
+
+    for (const auto &candidates : thread_candidates) {
+        result.top_outputs.insert(result.top_outputs.end(), candidates.begin(), candidates.end());
+    }
+    for (const auto &fills : thread_fills) {
+        for (const auto &fill : fills) {
+            if (result.top_outputs.size() < top_count) {
+                result.top_outputs.push_back(fill);
+            }
+        }
+    }
+
+    // Saturated counters only give a lower bound, so their preimages are counted again
+    std::vector<uint32_t> saturated;
+    for (const auto &[output, preimages] : result.top_outputs) {
+        if (preimages == max_value) {
+            saturated.push_back(output);
+        }
+    }
+
+    if (!saturated.empty()) {
+        std::sort(saturated.begin(), saturated.end());
+        std::vector<std::vector<uint64_t>> thread_counts(thread_count, std::vector<uint64_t>(saturated.size()));
+
+        sweep_elm<I>(thread_count, [&](const unsigned t, const uint32_t *, const uint32_t *outputs, const uint32_t count) {
+            for (uint32_t j = 0; j < count; j++) {
+                const auto it = std::lower_bound(saturated.begin(), saturated.end(), outputs[j]);
+                if (it != saturated.end() && *it == outputs[j]) {
+                    thread_counts[t][it - saturated.begin()]++;
+                }
+            }
+            return true;
+        }, table);
+
+        for (auto &[output, preimages] : result.top_outputs) {
+            const auto it = std::lower_bound(saturated.begin(), saturated.end(), output);
+            if (it != saturated.end() && *it == output) {
+                preimages = 0;
+                for (const std::vector<uint64_t> &counts : thread_counts) {
+                    preimages += counts[it - saturated.begin()];
+                }
+            }
+        }
+    }
+
+    std::sort(result.top_outputs.begin(), result.top_outputs.end(), more_preimages);
+
+    return result;
+}
+
+// Iteration counts n = floor(6 * gamma) of ELM, gamma in [0, 1]
+constexpr int ELM_N_COUNT = 7;
+
+// Collisions of one ELM variant by cause and by the iteration count n of the colliding input. An input collides if a
+// smaller input has the same output, so there are as many collisions as in the counting bijectivity sweep. The
+// collision is pre-combine if a smaller input also has the same w1 and w2, i.e. the float32 values already coincided,
+// and post-combine if only rotl(w1, 17) ^ w2 coincides.
+struct CollisionClassification {
+    std::array<uint64_t, ELM_N_COUNT> pre_combine{};
+    std::array<uint64_t, ELM_N_COUNT> post_combine{};
+    uint64_t collisions = 0;
+    // Outputs with at least two preimages
+    uint64_t colliding_outputs = 0;
+    // Sweeps of the second phase
+    uint64_t passes = 0;
+};
+
+// One input whose output collides: its output, its w1 and the input
+struct CollidingInput {
+    uint32_t y;
+    uint32_t w1;
+    uint32_t x;
+
+    bool operator<(const CollidingInput &other) const {
+        return y != other.y ? y < other.y : w1 != other.w1 ? w1 < other.w1 : x < other.x;
+    }
+};
+
+// Classifies all collisions of ELM<I> in two phases. The first phase is a counting sweep that marks every output with
+// more than one preimage in a second bitmap. The second phase sweeps the inputs again and evaluates ELM_instrumented
+// only for the inputs of marked outputs, keeping their output, w1 and x. These records are split by output range into
+// as many passes as needed to stay within memory_bytes; each pass sorts its records per thread, merges them by output
+// and classifies every output's preimages. Besides the records, the two phases need 1 GiB and 512 MiB of bitmaps.
+// table is passed on to sweep_elm and makes the repeated sweeps of the second phase cheap.
+template<typename I>
+CollisionClassification classify_collisions(const unsigned thread_count, const uint64_t memory_bytes,
+                                            const uint32_t *table = nullptr, ProgressReporter *progress = nullptr) {
+    CollisionClassification result;
+    OutputBitmap colliding;
+
+    {
+        OutputBitmap seen;
+        std::vector<ThreadCounter> collisions(thread_count), outputs_found(thread_count);
+        ProgressRun run(progress, {"Collision sweep", thread_count, ELM_DOMAIN_SIZE});
+
+        sweep_elm<I>(thread_count, [&](const unsigned t, const uint32_t *, const uint32_t *outputs, const uint32_t count) {
+            uint64_t found = 0;
+            for (uint32_t j = 0; j < count; j++) {
+                if (seen.test_and_set(outputs[j])) {
+                    found++;
+                    if (!colliding.test_and_set(outputs[j])) {
+                        outputs_found[t].value++;
+                    }
+                }
+            }
+            collisions[t].value += found;
+            run.add(t, count, count, found);
+            return true;
+        }, table, nullptr, SweepOrder::CostDescending);
+
+        for (unsigned t = 0; t < thread_count; t++) {
+            result.collisions += collisions[t].value;
+            result.colliding_outputs += outputs_found[t].value;
+        }
+    }
+
+    // Every colliding output contributes its first preimage and one record per collision. A quarter is added for the
+    // growth of the per-thread vectors.
+    const uint64_t records = result.collisions + result.colliding_outputs;
+    const uint64_t record_memory = records * sizeof(CollidingInput) / 4 * 5;
+    result.passes = std::max<uint64_t>(1, (record_memory + memory_bytes - 1) / std::max<uint64_t>(memory_bytes, 1));
+
+    std::vector<std::vector<CollidingInput>> thread_records(thread_count);
+    for (uint64_t pass = 0; pass < result.passes; pass++) {
+        const uint64_t first_output = ELM_DOMAIN_SIZE * pass / result.passes;
+        const uint64_t end_output = ELM_DOMAIN_SIZE * (pass + 1) / result.passes;
+        for (std::vector<CollidingInput> &records_of_thread : thread_records) {
+            records_of_thread.clear();
+            records_of_thread.reserve(records / result.passes / thread_count / 20 * 21);
+        }
+
+        {
+            ProgressRun run(progress, {"Classification pass " + std::to_string(pass + 1) + " of " + std::to_string(result.passes),
+                                       thread_count, ELM_DOMAIN_SIZE});
+
+            sweep_elm<I>(thread_count, [&](const unsigned t, const uint32_t *inputs, const uint32_t *outputs, const uint32_t count) {
+                uint64_t instrumented = 0;
+                for (uint32_t j = 0; j < count; j++) {
+                    const uint32_t y = outputs[j];
+                    if (y < first_output || y >= end_output || !colliding.test(y)) {
+                        continue;
+                    }
+                    thread_records[t].push_back({y, ELM_instrumented<I>(inputs[j]).w1, inputs[j]});
+                    instrumented++;
+                }
+                run.add(t, count, count + instrumented, 0);
+                return true;
+            }, table, nullptr, SweepOrder::CostDescending);
+        }
+
+        parallel_ranges(thread_count, thread_count, [&](unsigned, const uint64_t begin, const uint64_t end) {
+            for (uint64_t t = begin; t < end; t++) {
+                std::sort(thread_records[t].begin(), thread_records[t].end());
+            }
+        });
+
+        // Merges the sorted records of all threads and classifies the preimages of one output at a time
+        using Cursor = std::pair<CollidingInput, unsigned>;
+        std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> heads;
+        std::vector<std::size_t> positions(thread_count, 0);
+        for (unsigned t = 0; t < thread_count; t++) {
+            if (!thread_records[t].empty()) {
+                heads.push({thread_records[t][0], t});
+            }
+        }
+
+        std::vector<CollidingInput> preimages;
+        auto classify = [&] {
+            uint32_t first = preimages[0].x;
+            for (const CollidingInput &preimage : preimages) {
+                first = std::min(first, preimage.x);
+            }
+            // Sorted by w1: the first record of every w1 is its smallest input. With the same output, the same w1
+            // implies the same w2 = y ^ rotl(w1, 17).
+            for (std::size_t i = 0; i < preimages.size(); i++) {
+                const int n = ELM_parameters<I>(preimages[i].x).n;
+                if (i > 0 && preimages[i].w1 == preimages[i - 1].w1) {
+                    result.pre_combine[n]++;
+                } else if (preimages[i].x != first) {
+                    result.post_combine[n]++;
+                }
+            }
+            preimages.clear();
+        };
+
+        while (!heads.empty()) {
+            const auto [record, t] = heads.top();
+            heads.pop();
+            if (++positions[t] < thread_records[t].size()) {
+                heads.push({thread_records[t][positions[t]], t});
+            }
+            if (!preimages.empty() && preimages[0].y != record.y) {
+                classify();
+            }
+            preimages.push_back(record);
+        }
+        if (!preimages.empty()) {
+            classify();
+        }
+    }
+
+    return result;
+}
+
+#endif
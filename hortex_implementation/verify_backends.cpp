@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "elm_table.hpp"
+#include "equivalence.hpp"
+#include "hortex.hpp"
+#include "progress.hpp"
+#include "sweep.hpp"
+
+// Differential check of every optimized ELM, fFunction and hortex path against the reference (equivalence.hpp):
+// ELM on all 2^32 inputs of every ELM variant, fFunction on structured and random states and hortex on structured and
+// random messages of every interpretation. Prints the first differing input per candidate with the intermediate
+// values of ELM, and the fingerprint of the reference outputs, to compare builds with different compilers or flags.
+//
+// ./verify_backends <interpretation|all> <threads> <stride> <samples> <table_file> [--progress <seconds>] [--progress-json <file>]
+
+inline std::string hex_state(const State &state) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (const uint32_t word : state) {
+		ss << std::setw(8) << word;
+	}
+	return ss.str();
+}
+
+inline std::string hex_bytes(const uint8_t *bytes, const std::size_t len) {
+	std::ostringstream ss;
+	ss << std::hex << std::setfill('0');
+	for (std::size_t i = 0; i < len; i++) {
+		ss << std::setw(2) << static_cast<int>(bytes[i]);
+	}
+	return ss.str();
+}
+
+template<typename I>
+void print_elm_input(const char *label, const uint32_t x, const uint32_t candidate_output) {
+	const ELMInfo info = ELM_instrumented<I>(x);
+	std::cout << "    " << label << " x = " << x << " (x_left = " << info.x_left << ", x_middle = " << info.x_middle
+			  << ", x_right = " << info.x_right << ")" << std::endl;
+	std::cout << "      Reference: " << info.result << " (gamma = " << std::setprecision(17) << info.gamma
+			  << std::setprecision(6) << ", n = " << info.n << ", w1 = " << info.w1 << ", w2 = " << info.w2 << ")" << std::endl;
+	std::cout << "      Candidate: " << candidate_output << std::endl;
+}
+
+// Explains a difference of a state or a message by the first ELM call that the candidate evaluates differently
+template<typename I>
+void print_elm_cause(const std::vector<uint32_t> &inputs, const std::function<uint32_t(uint32_t)> &elm) {
+	const std::size_t position = first_elm_difference<I>(inputs, elm);
+	if (position == inputs.size()) {
+		std::cout << "    All " << inputs.size() << " ELM calls agree, the difference lies in the ARX layer, the packing or the sponge." << std::endl;
+		return;
+	}
+	std::cout << "    ELM call " << position << " of " << inputs.size() << " differs:" << std::endl;
+	print_elm_input<I>("", inputs[position], elm(inputs[position]));
+}
+
+int main(int argc, char *argv[]) {
+	ProgressOptions progress_options;
+	if (!take_progress_options(argc, argv, progress_options)) {
+		std::cerr << "Please provide --progress <seconds> and --progress-json <file> with a value." << std::endl;
+		return 0;
+	}
+
+	std::vector<int> interpretations;
+	unsigned long long thread_count = default_thread_count();
+	unsigned long long stride = 1;
+	unsigned long long samples = 65536;
+
+	if (argc < 2 || std::string(argv[1]) == "all") {
+		for (int id = 0; id < interpretation_count; id++) {
+			interpretations.push_back(id);
+		}
+	} else {
+		int interpretation;
+		if (!parse_interpretation(argv[1], interpretation)) {
+			std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside[,use_pseudocode_arx] (e.g. true,3,false) or all, for the first argument." << std::endl;
+			return 0;
+		}
+		interpretations.push_back(interpretation);
+	}
+
+	if (argc >= 3 && !parse_number(argv[2], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the second argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 4 && !parse_number(argv[3], 1, ELM_DOMAIN_SIZE / SWEEP_CHUNK_SIZE, stride)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 5 && !parse_number(argv[4], 0, 1ull << 32, samples)) {
+		std::cerr << "Please provide a number, for the fourth argument." << std::endl;
+		return 0;
+	}
+
+	std::unique_ptr<ELMTable> table;
+	if (argc >= 6) {
+		try {
+			table = std::make_unique<ELMTable>(argv[5]);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Please provide an ELM table written by generate_elm_table, for the fifth argument." << std::endl;
+			return 0;
+		}
+	}
+
+	const std::vector<std::string> problems = floating_point_environment_problems();
+	if (!problems.empty()) {
+		std::cout << "The floating-point environment differs from the IEEE 754 defaults of the reference:" << std::endl;
+		for (const std::string &problem : problems) {
+			std::cout << "  " << problem << std::endl;
+		}
+		return 1;
+	}
+
+	std::unique_ptr<ProgressReporter> progress;
+	if (progress_options.enabled()) {
+		try {
+			progress = std::make_unique<ProgressReporter>(static_cast<double>(progress_options.interval_seconds), progress_options.json_path);
+		} catch (const std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			return 0;
+		}
+	}
+
+	const unsigned threads = static_cast<unsigned>(thread_count);
+	std::cout << "Backend: " << backend_name(detected_backend()) << ", " << threads << " threads, every " << stride
+			  << ". chunk of ELM inputs, " << samples << " random states, " << samples / 16 << " random messages" << std::endl;
+
+	bool all_identical = true;
+	auto report = [&](const std::string &candidate, const EquivalenceDifference &difference) {
+		std::cout << "  " << candidate << ": " << (difference.found ? "DIFFERENT" : "identical") << std::endl;
+		all_identical = all_identical && !difference.found;
+		return difference.found;
+	};
+
+	std::cout << "ELM:" << std::endl;
+	for (const int interpretation : interpretations) {
+		// ELM ignores use_pseudocode_arx, every ELM variant is checked once
+		if ((interpretation & 1) == 0 && std::find(interpretations.begin(), interpretations.end(), interpretation | 1) != interpretations.end()) {
+			continue;
+		}
+		with_elm_interpretation(interpretation, [&]<typename I>(I) {
+			const std::vector<ELMCandidate<I>> candidates = elm_candidates<I>(table.get());
+			uint64_t fingerprint;
+			const std::vector<EquivalenceDifference> differences = verify_elm<I>(candidates, threads, stride, fingerprint, progress.get());
+
+			std::cout << "Interpretation " << interpretation_name(I::id, false) << ", reference fingerprint 0x" << std::hex
+					  << std::setw(16) << std::setfill('0') << fingerprint << std::dec << std::setfill(' ') << std::endl;
+			for (std::size_t c = 0; c < candidates.size(); c++) {
+				if (report(candidates[c].name, differences[c])) {
+					const uint32_t x = static_cast<uint32_t>(differences[c].index);
+					// A single input may take another path than a full batch, so the output is taken from its chunk
+					std::vector<uint32_t> chunk_inputs(SWEEP_CHUNK_SIZE), chunk_outputs(SWEEP_CHUNK_SIZE);
+					for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+						chunk_inputs[j] = (x & ~(SWEEP_CHUNK_SIZE - 1)) + j;
+					}
+					candidates[c].batch(chunk_inputs.data(), chunk_outputs.data(), SWEEP_CHUNK_SIZE);
+					print_elm_input<I>("First difference at", x, chunk_outputs[x & (SWEEP_CHUNK_SIZE - 1)]);
+				}
+			}
+		});
+	}
+
+	const std::vector<State> states = equivalence_states(static_cast<std::size_t>(samples), 1);
+	std::vector<std::vector<uint8_t>> message_bytes;
+	const std::vector<HortexMessage> messages = equivalence_messages(static_cast<std::size_t>(samples / 16), 2, message_bytes);
+
+	std::cout << "fFunction and hortex (" << states.size() << " states, " << messages.size() << " messages):" << std::endl;
+	for (const int interpretation : interpretations) {
+		with_interpretation(interpretation, [&]<typename I>(I) {
+			std::cout << "Interpretation " << interpretation_name(I::id) << std::endl;
+
+			const std::vector<StateCandidate<I>> state_tests = state_candidates<I>(table.get());
+			const std::vector<EquivalenceDifference> state_differences = verify_ffunction<I>(state_tests, states, threads);
+			for (std::size_t c = 0; c < state_tests.size(); c++) {
+				if (report("fFunction " + state_tests[c].name, state_differences[c])) {
+					const State &state = states[state_differences[c].index];
+					State output = state;
+					state_tests[c].apply(&output, 1);
+					std::cout << "    First difference at state " << state_differences[c].index << ": " << hex_state(state) << std::endl;
+					std::cout << "      Reference: " << hex_state(fFunction<I>(state)) << std::endl;
+					std::cout << "      Candidate: " << hex_state(output) << std::endl;
+					print_elm_cause<I>(ffunction_elm_inputs<I>(state), state_tests[c].elm);
+				}
+			}
+
+			const std::vector<MessageCandidate<I>> message_tests = message_candidates<I>(table.get());
+			const std::vector<EquivalenceDifference> message_differences = verify_hortex<I>(message_tests, messages, threads);
+			for (std::size_t c = 0; c < message_tests.size(); c++) {
+				if (report(message_tests[c].name, message_differences[c])) {
+					const HortexMessage &message = messages[message_differences[c].index];
+					uint8_t reference[Hortex<I>::digest_size], digest[Hortex<I>::digest_size];
+					reference_hortex<I>(message, reference, ComputedELM<I>{});
+					message_tests[c].hash(&message, 1, digest);
+					std::cout << "    First difference at message " << message_differences[c].index << " of " << message.len
+							  << " bytes: " << hex_bytes(message.data, message.len) << std::endl;
+					std::cout << "      Reference: " << hex_bytes(reference, sizeof(reference)) << std::endl;
+					std::cout << "      Candidate: " << hex_bytes(digest, sizeof(digest)) << std::endl;
+					print_elm_cause<I>(hortex_elm_inputs<I>(message), message_tests[c].elm);
+				}
+			}
+		});
+	}
+
+	// The fFunction and hortex checks are always samples, the ELM check is only exhaustive with stride 1
+	if (all_identical && stride == 1) {
+		std::cout << "All candidates produce the outputs of the reference." << std::endl;
+		return 0;
+	}
+	if (all_identical) {
+		std::cout << "All candidates produce the outputs of the reference on the sampled inputs, ELM on one chunk in " << stride
+				  << ". Run with stride 1 to check all ELM inputs." << std::endl;
+		return 0;
+	}
+	std::cout << "Some candidates differ from the reference." << std::endl;
+	return 1;
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "arguments.hpp"
+#include "elm_batch.hpp"
+#include "hortex.hpp"
+#include "sweep.hpp"
+
+// Compares ELM_batch, which evaluates exp2 with the vector kernel of fast_exp2.hpp, with the scalar ELM, which calls
+// the system exp2, over all 2^32 inputs. Proves for the C library in use that the vector exp2 changes no output.
+//
+// ./verify_exp2 <interpretation|all> <threads> <stride>
+
+struct Mismatch {
+	bool found = false;
+	uint32_t input = 0;
+};
+
+// Checks every stride-th chunk of SWEEP_CHUNK_SIZE inputs and returns the smallest input whose outputs differ. The
+// chunks are handed out by cost, so all threads finish together although ELM costs more for large x_left.
+template<typename I>
+Mismatch verify_interpretation(const unsigned thread_count, const uint64_t stride) {
+	std::vector<Mismatch> mismatches(thread_count);
+	std::vector<std::vector<uint32_t>> inputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+	std::vector<std::vector<uint32_t>> outputs(thread_count, std::vector<uint32_t>(SWEEP_CHUNK_SIZE));
+
+	sweep_chunks(thread_count, SweepSchedule(SweepOrder::CostDescending, stride), [&](const unsigned t, const uint64_t chunk_start) {
+		for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+			inputs[t][j] = static_cast<uint32_t>(chunk_start + j);
+		}
+		ELM_batch<I>(inputs[t].data(), outputs[t].data(), SWEEP_CHUNK_SIZE);
+
+		for (uint32_t j = 0; j < SWEEP_CHUNK_SIZE; j++) {
+			if (outputs[t][j] != ELM<I>(inputs[t][j])) {
+				if (!mismatches[t].found || inputs[t][j] < mismatches[t].input) {
+					mismatches[t] = {true, inputs[t][j]};
+				}
+				break;
+			}
+		}
+		return true;
+	}, nullptr);
+
+	Mismatch first;
+	for (const Mismatch &mismatch : mismatches) {
+		if (mismatch.found && (!first.found || mismatch.input < first.input)) {
+			first = mismatch;
+		}
+	}
+	return first;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned long long thread_count = default_thread_count();
+	unsigned long long stride = 1;
+	std::vector<int> interpretations;
+
+	if (argc < 2 || std::string(argv[1]) == "all") {
+		for (int id = 1; id < 32; id += 2) {
+			interpretations.push_back(id);
+		}
+	} else {
+		int interpretation;
+		if (!parse_interpretation(argv[1], interpretation)) {
+			std::cerr << "Please provide the interpretation as use_improved_elm,constants_setting,multiplier_is_outside (e.g. true,3,false) or all, for the first argument." << std::endl;
+			return 0;
+		}
+		interpretations.push_back(interpretation);
+	}
+
+	if (argc >= 3 && !parse_number(argv[2], 1, 4096, thread_count)) {
+		std::cerr << "Please provide a number starting from 1, for the second argument." << std::endl;
+		return 0;
+	}
+
+	if (argc >= 4 && !parse_number(argv[3], 1, ELM_DOMAIN_SIZE / SWEEP_CHUNK_SIZE, stride)) {
+		std::cerr << "Please provide a number starting from 1, for the third argument." << std::endl;
+		return 0;
+	}
+
+	std::cout << "Backend: " << backend_name(detected_backend()) << std::endl;
+	if (detected_backend() != ELMBackend::AVX512) {
+		std::cout << "The vector exp2 is only used with AVX-512, this run only compares the other batch steps." << std::endl;
+	}
+
+	bool all_identical = true;
+
+	for (const int interpretation : interpretations) {
+		with_elm_interpretation(interpretation, [&]<typename I>(I) {
+			const Mismatch mismatch = verify_interpretation<I>(thread_count, stride);
+
+			std::cout << "Interpretation " << interpretation_name(interpretation, false) << ": ";
+			if (!mismatch.found) {
+				std::cout << "identical" << std::endl;
+				return;
+			}
+
+			all_identical = false;
+			const ELMInfo info = ELM_instrumented<I>(mismatch.input);
+			// The batch of 8 inputs containing x, a single input would take the scalar path
+			uint32_t batch_inputs[8], batch_outputs[8];
+			for (uint32_t j = 0; j < 8; j++) {
+				batch_inputs[j] = (mismatch.input & ~7u) + j;
+			}
+			ELM_batch<I>(batch_inputs, batch_outputs, 8);
+			std::cout << "different outputs, first at x = " << info.x << std::endl;
+			std::cout << "  Scalar: " << info.result << " (gamma = " << info.gamma << ", n = " << info.n << ", w1 = " << info.w1 << ", w2 = " << info.w2 << ")" << std::endl;
+			std::cout << "  Batch:  " << batch_outputs[mismatch.input & 7] << std::endl;
+		});
+	}
+
+	// Only the exhaustive check is a proof, a stride only samples the inputs
+	if (all_identical && stride == 1) {
+		std::cout << "The vector exp2 produces the same outputs as the system exp2." << std::endl;
+	} else if (all_identical) {
+		std::cout << "The vector exp2 produces the same outputs as the system exp2 on the checked chunks of " << SWEEP_CHUNK_SIZE << " inputs, one in " << stride << ". Run with stride 1 to check all inputs." << std::endl;
+	}
+	return 0;
+}